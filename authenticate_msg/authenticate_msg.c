@@ -7,11 +7,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include "../lib/blumblumshub.h"
+#include <string.h>
 #include "../lib/math_opts.h"
 #include "../lib/rsa_opts.h"
 #include "../lib/general_opts.h"
+#include "../lib/merkle_opts.h"
 #include "../lib/bit_opts.h"
+#include "../lib/envelope.h"
 
 /**
  * @mainpage RSA Message Encryption and Authentication with X-509
@@ -44,12 +46,16 @@
  * the project is taken from another open source project Aescrypt @link http://www.aescrypt.com @endlink . The hash that SHA generates, is 256 bits.
  *
  * @section intro2 Compiling The Project
- * There are 3 parts in the project that has to be compiled separately. First file is create_rsa_keys.c file. Second file is sender.c file and the third
- * is receiver.c file. To be able to compile them we need to install the GMP library from the package manager of your Linux/Unix distribution or download
- * and install from its web site @link http://www.gmplib.com @endlink . To compile the program;
+ * The functions are in the library in the lib directory, and the three programs and the benchmark are linked with it. To be able to compile them
+ * we need to install the GMP library from the package manager of your Linux/Unix distribution or download and install from its web site
+ * @link http://www.gmplib.com @endlink . To compile the library and the programs;
  * @code
- * gcc -O2 file.c -o file -lm -lgmp
+ * make
  * @endcode
+ * The static and shared libraries librsa_meax.a and librsa_meax.so are put in the build directory and the programs in build/bin. "make lto" builds
+ * the same with link time optimization in build/lto, and "make pgo" builds with link time optimization and the profile of a benchmark run
+ * in build/pgo, so the exponentiation and the hashing loops are inlined across the files and laid out by the profile.
+ * "make check" builds and runs the checks in the tests directory.
  *
  * After the compilation you can run according to the description below.
  *
@@ -73,6 +79,9 @@
  * ./send_message input_message_file sender's_private_key receiver's_public_key
  * @endcode
  * After running the program it creates a msg_to_send file in the same directory it is the file that will be sent to the receiver.
+ * The message, its signature and the fingerprint of the sender's key are put in a binary envelope before they are encrypted, each
+ * field starts with its length, see envelope.h. authenticate_msg still accepts the messages of the older versions, which separate
+ * the message and the decimal signature with a separator line.
  * @subsection sb3 Authenticating the received message
  * The final, third part is the authenticating the received encrypted message. The authenticate_msg.c file also takes 3 arguments. First is the received message file,
  * the second is the receiver's private key file and the third is the sender's public key file. Example run would be like;
@@ -80,49 +89,133 @@
  * ./authenticate_msg received_msg_file receiver's_private_key_file sender's_public_key_file
  * @endcode
  *
+ * @subsection sb4 Using more threads
+ * The blocks of a message are encrypted and decrypted independently, so send_message and authenticate_msg can spread them over
+ * worker threads with the "--threads N" option. N is a positive number, the default is 1.
+ * @code
+ * ./authenticate_msg --threads 8 received_msg_file receiver's_private_key_file sender's_public_key_file
+ * @endcode
+ *
+ * @subsection sb5 Streaming big messages
+ * With the "--stream" option send_message reads, encrypts and writes the message piece by piece with a fixed amount of memory,
+ * the disk reads and writes are done while the worker threads are encrypting.
+ * @code
+ * ./send_message --stream --threads 8 input_message_file sender's_private_key receiver's_public_key
+ * @endcode
+ *
+ * @subsection sb6 Hybrid mode
+ * With the "--hybrid" option send_message encrypts only a random session key with the receiver's RSA key, and the message with the
+ * ChaCha20 stream cipher under that session key. This is much faster for big messages, the key files are the same. authenticate_msg
+ * finds the mode from the received file.
+ * @code
+ * ./send_message --hybrid input_message_file sender's_private_key receiver's_public_key
+ * @endcode
+ *
+ * @subsection sb7 Merkle signatures
+ * With the "--merkle" option send_message hashes the message in 1 MB chunks on the worker threads and signs the root of the
+ * tree of the chunk hashes, instead of the hash of the whole message. The chunk size and the arity of the tree are written in
+ * the header of the envelope, and authenticate_msg builds the same tree with its own threads. It can be used with the other options.
+ * @code
+ * ./send_message --merkle --threads 8 input_message_file sender's_private_key receiver's_public_key
+ * @endcode
+ *
+ * @subsection sb8 Benchmarks
+ * bench/bench.c measures the key generation, the exponentiation, pub_enc and pri_dec for each key size from 512 to 8192 bits,
+ * and the hashing and the character compression. The keys are generated from a fixed seed so each run uses the same keys.
+ * The results are printed as JSON with the median and the percentiles of the runs, save them and compare two releases with a diff.
+ * @code
+ * ./bench --sizes 1024,2048 --reps 11 > results.json
+ * @endcode
+ *
  *
  *
  *
  */
 
+/**
+ *
+ * @param decrypted_msg Decrypted message of an older version, the plain text and the decimal signature with the separator
+ * @param s_pu Sender's public key
+ * @return 1 if the message is authenticated, 0 otherwise, also when there is no separator
+ *
+ * @brief Authenticates the messages which are not in an envelope.
+ */
+int authenticate_legacy_msg(char* decrypted_msg,rsa_key* s_pu){
+	char *id,*ds,*sender_hash,*receiver_hash;
+	int result;
+
+	id = extract_id(decrypted_msg);
+	ds = extract_ds(decrypted_msg);
+	if(id == NULL || ds == NULL){
+		free(id);
+		free(ds);
+		return 0;
+	}
+
+	if(is_merkle_ds(ds)){// the tree is built again with the receiver's threads
+		receiver_hash = create_merkle_hash_for_ds(id,strlen(id),ds);
+		sender_hash = pub_dec(merkle_ds_signature(ds),s_pu);
+	}
+	else{
+		receiver_hash = create_hash_of_string(id,strlen(id));
+		sender_hash = pub_dec(ds,s_pu);
+	}
+	result = authenticate(receiver_hash,sender_hash);
+
+	free(id);
+	free(ds);
+	free(receiver_hash);
+	free(sender_hash);
+	return result;
+}
+
 int main(int argc,char** argv) {
 	rsa_key *r_pr, *s_pu;
-	char *received_msg, *decrypted_msg, *id,*ds,*sender_hash,*receiver_hash;
-	int id_size;
+	mapped_file *received_msg;
+	char *received_text, *decrypted_msg;
+	size_t decrypted_size;
+	envelope env;
+	int result;
 
+	parse_threads_option(&argc,argv);
 	if(argc != 4){
-		fprintf(stderr,"Usage : ./authenticate_msg message_file receiver's_private_key sender's_public_key\n");
+		fprintf(stderr,"Usage : ./authenticate_msg [--threads N] message_file receiver's_private_key sender's_public_key\n");
 		exit(0);
 	}
 
-	received_msg = read_file_to_string(argv[1]);
+	received_msg = map_file(argv[1]);
 	r_pr = get_key_from_file(argv[2]);
 	s_pu = get_key_from_file(argv[3]);
 
-	decrypted_msg = pri_dec(received_msg,r_pr);
-
-	id = extract_id(decrypted_msg);
-	ds = extract_ds(decrypted_msg);
-
+	if(is_cipher_container(received_msg->data,received_msg->size)){
+		decrypted_msg = pri_dec_container(received_msg->data,received_msg->size,r_pr,&decrypted_size);
+	}
+	else{ // decimal text messages of the older versions need a terminated copy
+		received_text = (char*)malloc((received_msg->size+1)*sizeof(char));
+		memcpy(received_text,received_msg->data,received_msg->size);
+		received_text[received_msg->size] = '\0';
+		decrypted_msg = pri_dec(received_text,r_pr);
+		decrypted_size = strlen(decrypted_msg);
+		free(received_text);
+	}
 
-	receiver_hash = create_hash_of_string(id,strlen(id));
-	sender_hash = pub_dec(ds,s_pu);
+	// the fields of an envelope are used in place, the older messages are split at the separator
+	if(decrypted_size >= strlen(ENVELOPE_MAGIC) && memcmp(decrypted_msg,ENVELOPE_MAGIC,strlen(ENVELOPE_MAGIC)) == 0)
+		result = parse_envelope(decrypted_msg,decrypted_size,&env) && authenticate_envelope(&env,s_pu);
+	else
+		result = authenticate_legacy_msg(decrypted_msg,s_pu);
 
-	if(!authenticate(receiver_hash,sender_hash)){
+	if(!result){
 		printf("Authentication failed!!\n");
 	}
 	else{
 		printf("Authentication Successful!\n");
 	}
 
-	free(received_msg);
+	unmap_file(received_msg);
 	free(r_pr);
 	free(s_pu);
 	free(decrypted_msg);
-	free(id);
-	free(ds);
-	free(receiver_hash);
-	free(sender_hash);
 
 	return EXIT_SUCCESS;
 }
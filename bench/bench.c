@@ -0,0 +1,419 @@
+/**
+ * @file
+ * @brief Main function of the benchmarks.
+ *
+ * The file measures the hot paths of the project for each key size and prints the results as JSON, so the results of
+ * two releases can be compared with a diff. Each benchmark is run several times and the median and the percentiles
+ * of the runs are reported. The keys are generated from a fixed seed, so every run uses the same keys.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../lib/math_opts.h"
+#include "../lib/rsa_opts.h"
+#include "../lib/general_opts.h"
+#include "../lib/bit_opts.h"
+
+/**
+ * Default key sizes in bits.
+ */
+#define BENCH_SIZES "512,1024,2048,4096,8192"
+/**
+ * Default number of runs of each benchmark.
+ */
+#define BENCH_REPS 11
+/**
+ * Default number of runs of the key generation, it is much slower than the others.
+ */
+#define BENCH_KEYGEN_REPS 5
+/**
+ * A run of the fast benchmarks repeats the operation for at least this many seconds.
+ */
+#define BENCH_MIN_TIME 0.05
+/**
+ * Size of the message encrypted by pub_enc, it is 64 blocks.
+ */
+#define BENCH_MESSAGE_SIZE 256
+/**
+ * Size of the buffer and the file hashed by the hash benchmarks.
+ */
+#define BENCH_HASH_SIZE (16 << 20)
+
+/**
+ * @return Monotonic time in seconds
+ */
+double bench_now(void){
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+/**
+ *
+ * @param a First sample
+ * @param b Second sample
+ * @return Order of the samples for qsort
+ */
+int bench_cmp(const void* a,const void* b){
+	double x = *(const double*)a, y = *(const double*)b;
+
+	return x < y ? -1 : x > y;
+}
+/**
+ *
+ * @param s Sorted samples
+ * @param n Number of samples
+ * @param p Percentile, 0 to 100
+ * @return The percentile, interpolated between the two nearest samples
+ */
+double bench_percentile(const double* s,int n,double p){
+	double pos = (n - 1) * p / 100.0;
+	int i = (int)pos;
+
+	if(i + 1 >= n)
+		return s[n-1];
+	return s[i] + (pos - i) * (s[i+1] - s[i]);
+}
+/**
+ *
+ * @param name Name of the benchmark
+ * @param unit Unit of the samples
+ * @param s Samples, they are sorted
+ * @param n Number of samples
+ * @param last 1 if it is the last benchmark of its object
+ *
+ * @brief Prints the statistics of the samples as a JSON member.
+ */
+void bench_report(char* name,char* unit,double* s,int n,int last){
+	qsort(s,n,sizeof(double),bench_cmp);
+	printf("      \"%s\": {\"unit\": \"%s\", \"samples\": %d, \"min\": %.6g, \"p10\": %.6g, \"median\": %.6g, "
+			"\"p90\": %.6g, \"p99\": %.6g, \"max\": %.6g}%s\n",
+			name,unit,n,s[0],bench_percentile(s,n,10),bench_percentile(s,n,50),bench_percentile(s,n,90),
+			bench_percentile(s,n,99),s[n-1],last ? "" : ",");
+}
+
+/**
+ * @struct BENCH_KEYS
+ * @brief BENCH_KEYS holds the fixed keys of a key size.
+ */
+typedef struct BENCH_KEYS {
+	rsa_keys* keys; // the generated keys
+	rsa_key pu; // public key
+	rsa_key pr; // private key with the CRT components
+}bench_keys;
+
+/**
+ *
+ * @param bits Key size
+ * @return Keys generated from a seed made of the key size
+ *
+ * @brief Generates the same keys in every run, p and q come from a seeded ChaCha20 DRBG.
+ */
+bench_keys* create_bench_keys(int bits){
+	bench_keys* bk = (bench_keys*)malloc(sizeof(bench_keys));
+	rsa_key_base* key_base = (rsa_key_base*)malloc(sizeof(rsa_key_base));
+	unsigned char seed[32];
+	rand_source* src;
+	mpz_t* prime;
+	int i,coprime;
+
+	memset(seed,0,sizeof(seed));
+	snprintf((char*)seed,sizeof(seed),"rsa_meax bench %d",bits);
+	src = create_seeded_chacha_rand_source(seed,sizeof(seed));
+
+	mpz_init(key_base->p);
+	mpz_init(key_base->q);
+	mpz_init(key_base->n);
+	mpz_init(key_base->phi);
+	key_base->e = RSA_DEFAULT_E;
+	for(i = 0; i < 2; i++){
+		do {// prime - 1 has to be coprime to e and p != q
+			prime = create_random_prime_gmp_number_from_source(src,bits/2,1);
+			mpz_set(i == 0 ? key_base->p : key_base->q,*prime);
+			mpz_sub_ui(*prime,*prime,1);
+			coprime = mpz_gcd_ui(NULL,*prime,RSA_DEFAULT_E) == 1;
+			mpz_clear(*prime);
+			free(prime);
+		}while(!coprime || (i == 1 && mpz_cmp(key_base->p,key_base->q) == 0));
+	}
+	mpz_mul(key_base->n,key_base->p,key_base->q);
+	mpz_sub(key_base->phi,key_base->n,key_base->p);
+	mpz_sub(key_base->phi,key_base->phi,key_base->q);
+	mpz_add_ui(key_base->phi,key_base->phi,1); // phi = p x q - p - q + 1
+	src->destroy(src);
+
+	bk->keys = create_pub_key(key_base);
+
+	mpz_init_set(bk->pu.k,bk->keys->pu);
+	mpz_init_set(bk->pu.n,bk->keys->n);
+	mpz_init(bk->pu.p);
+	mpz_init(bk->pu.q);
+	mpz_init(bk->pu.dp);
+	mpz_init(bk->pu.dq);
+	mpz_init(bk->pu.qinv);
+	bk->pu.crt = 0;
+	bk->pu.ctx = NULL;
+
+	mpz_init_set(bk->pr.k,bk->keys->pr);
+	mpz_init_set(bk->pr.n,bk->keys->n);
+	mpz_init_set(bk->pr.p,bk->keys->p);
+	mpz_init_set(bk->pr.q,bk->keys->q);
+	mpz_init_set(bk->pr.dp,bk->keys->dp);
+	mpz_init_set(bk->pr.dq,bk->keys->dq);
+	mpz_init_set(bk->pr.qinv,bk->keys->qinv);
+	bk->pr.crt = 1;
+	bk->pr.ctx = NULL;
+
+	free_rsa_key_base(key_base);
+	return bk;
+}
+/**
+ *
+ * @param bits Key size
+ * @param reps Number of runs
+ *
+ * @brief Times generate_rsa_key_base and create_pub_key, these keys are not seeded.
+ */
+void bench_keygen(int bits,int reps){
+	double* s = (double*)malloc(reps*sizeof(double));
+	rsa_key_base* key_base;
+	rsa_keys* keys;
+	double t;
+	int i;
+
+	for(i = 0; i < reps; i++){
+		t = bench_now();
+		key_base = generate_rsa_key_base(bits);
+		keys = create_pub_key(key_base);
+		s[i] = bench_now() - t;
+		free_rsa_key_base(key_base);
+		free_rsa_keys(keys);
+	}
+	bench_report("keygen","s",s,reps,0);
+	free(s);
+}
+/**
+ *
+ * @param bk The keys
+ * @param reps Number of runs
+ *
+ * @brief Measures take_mod_of_exp_number2 with the full size private exponent, in operations per second.
+ */
+void bench_modexp(bench_keys* bk,int reps){
+	double* s = (double*)malloc(reps*sizeof(double));
+	mpz_t f,base;
+	double t;
+	long ops,batch = 1;
+	int i;
+
+	mpz_init(f);
+	mpz_init(base);
+	mpz_sub_ui(base,bk->keys->n,12345);
+
+	t = bench_now(); // one operation sets the batch size
+	take_mod_of_exp_number2(f,base,bk->keys->pr,bk->keys->n);
+	t = bench_now() - t;
+	if(t < BENCH_MIN_TIME)
+		batch = (long)(BENCH_MIN_TIME / t) + 1;
+
+	for(i = 0; i < reps; i++){
+		t = bench_now();
+		for(ops = 0; ops < batch; ops++)
+			take_mod_of_exp_number2(f,base,bk->keys->pr,bk->keys->n);
+		s[i] = batch / (bench_now() - t);
+	}
+	bench_report("take_mod_of_exp_number2","ops/s",s,reps,0);
+
+	mpz_clear(f);
+	mpz_clear(base);
+	free(s);
+}
+/**
+ *
+ * @param bk The keys
+ * @param reps Number of runs
+ *
+ * @brief Measures pub_enc and pri_dec on a BENCH_MESSAGE_SIZE bytes message, in plain text bytes per second.
+ */
+void bench_pub_enc_pri_dec(bench_keys* bk,int reps){
+	double* enc = (double*)malloc(reps*sizeof(double));
+	double* dec = (double*)malloc(reps*sizeof(double));
+	char m[BENCH_MESSAGE_SIZE + 1];
+	char *c,*d;
+	double t;
+	int i;
+
+	for(i = 0; i < BENCH_MESSAGE_SIZE; i++)
+		m[i] = 'a' + i % 26;
+	m[BENCH_MESSAGE_SIZE] = '\0';
+
+	for(i = 0; i < reps; i++){
+		t = bench_now();
+		c = pub_enc(m,&bk->pu);
+		enc[i] = BENCH_MESSAGE_SIZE / (bench_now() - t);
+
+		t = bench_now();
+		d = pri_dec(c,&bk->pr);
+		dec[i] = BENCH_MESSAGE_SIZE / (bench_now() - t);
+
+		if(strcmp(d,m) != 0){
+			fprintf(stderr,"pri_dec did not give the plain text back (bench_pub_enc_pri_dec)\n");
+			exit(0);
+		}
+		free(c);
+		free(d);
+	}
+	bench_report("pub_enc","B/s",enc,reps,0);
+	bench_report("pri_dec","B/s",dec,reps,1);
+	free(enc);
+	free(dec);
+}
+/**
+ *
+ * @param reps Number of runs
+ *
+ * @brief Measures create_hash_of_string and create_hash_of_file in bytes per second.
+ *
+ * The file is written to a temporary file first, it is read from the page cache.
+ */
+void bench_hash(int reps){
+	double* s = (double*)malloc(reps*sizeof(double));
+	char* buf = (char*)malloc(BENCH_HASH_SIZE);
+	char filename[] = "/tmp/rsa_meax_benchXXXXXX";
+	char* hash;
+	double t;
+	int i,fd;
+
+	for(i = 0; i < BENCH_HASH_SIZE; i++)
+		buf[i] = (char)(i * 131 + 7);
+
+	for(i = 0; i < reps; i++){
+		t = bench_now();
+		hash = create_hash_of_string(buf,BENCH_HASH_SIZE);
+		s[i] = BENCH_HASH_SIZE / (bench_now() - t);
+		free(hash);
+	}
+	bench_report("create_hash_of_string","B/s",s,reps,0);
+
+	if((fd = mkstemp(filename)) < 0){
+		fprintf(stderr,"mkstemp Failed (bench_hash)");
+		exit(0);
+	}
+	close(fd);
+	write_buffer_to_file(filename,buf,BENCH_HASH_SIZE);
+	for(i = 0; i < reps; i++){
+		t = bench_now();
+		hash = create_hash_of_file(filename);
+		s[i] = BENCH_HASH_SIZE / (bench_now() - t);
+		free(hash);
+	}
+	bench_report("create_hash_of_file","B/s",s,reps,0);
+	unlink(filename);
+
+	free(buf);
+	free(s);
+}
+/**
+ *
+ * @param reps Number of runs
+ *
+ * @brief Measures compress_chars_to_int in nanoseconds per call.
+ */
+void bench_compress(int reps){
+	double* s = (double*)malloc(reps*sizeof(double));
+	char str[5] = "abcd";
+	volatile int sink = 0;
+	long calls,batch = 100000;
+	double t;
+	int i;
+
+	for(i = 0; i < reps; i++){
+		t = bench_now();
+		for(calls = 0; calls < batch; calls++){
+			str[calls & 3] = 'a' + (calls & 15);
+			sink += compress_chars_to_int(str);
+		}
+		s[i] = (bench_now() - t) * 1e9 / batch;
+	}
+	bench_report("compress_chars_to_int","ns/call",s,reps,0);
+	free(s);
+}
+/**
+ *
+ * @param reps Number of runs
+ *
+ * @brief Measures pack_char_blocks and unpack_char_blocks in bytes per second on BENCH_HASH_SIZE bytes.
+ */
+void bench_codec(int reps){
+	double* pack = (double*)malloc(reps*sizeof(double));
+	double* unpack = (double*)malloc(reps*sizeof(double));
+	char* buf = (char*)malloc(BENCH_HASH_SIZE);
+	uint32_t* blocks = (uint32_t*)malloc(BENCH_HASH_SIZE);
+	double t;
+	int i;
+
+	for(i = 0; i < BENCH_HASH_SIZE; i++)
+		buf[i] = (char)('a' + i % 26);
+
+	for(i = 0; i < reps; i++){
+		t = bench_now();
+		pack_char_blocks(buf,BENCH_HASH_SIZE,blocks);
+		pack[i] = BENCH_HASH_SIZE / (bench_now() - t);
+		t = bench_now();
+		unpack_char_blocks(blocks,BENCH_HASH_SIZE/4,buf);
+		unpack[i] = BENCH_HASH_SIZE / (bench_now() - t);
+	}
+	bench_report("pack_char_blocks","B/s",pack,reps,0);
+	bench_report("unpack_char_blocks","B/s",unpack,reps,1);
+
+	free(pack);
+	free(unpack);
+	free(buf);
+	free(blocks);
+}
+
+int main(int argc,char** argv) {
+	char sizes_default[] = BENCH_SIZES;
+	char *sizes = sizes_default,*value,*size,*n_str,*hash;
+	int reps = BENCH_REPS,keygen_reps = BENCH_KEYGEN_REPS;
+	int bits,first = 1;
+	bench_keys* bk;
+
+	parse_threads_option(&argc,argv);
+	if((value = parse_value_option(&argc,argv,"--sizes")) != NULL)
+		sizes = value;
+	if((value = parse_value_option(&argc,argv,"--reps")) != NULL)
+		reps = atoi(value);
+	if((value = parse_value_option(&argc,argv,"--keygen-reps")) != NULL)
+		keygen_reps = atoi(value);
+	if(argc != 1 || reps < 1 || keygen_reps < 1){
+		fprintf(stderr,"Usage : ./bench [--threads N] [--sizes 512,1024,...] [--reps N] [--keygen-reps N]\n");
+		exit(0);
+	}
+
+	printf("{\n  \"threads\": %d,\n  \"reps\": %d,\n  \"common\": {\n",block_engine_threads,reps);
+	bench_hash(reps);
+	bench_compress(reps);
+	bench_codec(reps);
+	printf("  },\n  \"sizes\": {\n");
+
+	for(size = strtok(sizes,","); size != NULL; size = strtok(NULL,",")){
+		bits = atoi(size);
+		bk = create_bench_keys(bits);
+		n_str = mpz_get_str(NULL,DECIMAL,bk->keys->n);
+		hash = create_hash_of_string(n_str,strlen(n_str));
+		printf("%s    \"%d\": {\n      \"key\": \"%.16s\",\n",first ? "" : "    },\n",bits,hash); // the same in every run
+		free(n_str);
+		free(hash);
+		bench_keygen(bits,keygen_reps);
+		bench_modexp(bk,reps);
+		bench_pub_enc_pri_dec(bk,reps);
+		fflush(stdout);
+		first = 0;
+	}
+	printf("%s  }\n}\n",first ? "" : "    }\n");
+	return EXIT_SUCCESS;
+}
@@ -8,16 +8,49 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include "../lib/blumblumshub.h"
 #include "../lib/math_opts.h"
 #include "../lib/rsa_opts.h"
 #include "../lib/general_opts.h"
 #include "../lib/bit_opts.h"
+#include "../lib/key_pool.h"
 
 int main(int argc,char** argv) {
 	int key_length = 1024;
+	unsigned long e = RSA_DEFAULT_E;
+	char* e_option;
+	char* bbs_option;
+	char* pool_option;
+	char* pool_dir = KEY_POOL_DIR;
+	char* value;
+	int watermark = KEY_POOL_WATERMARK;
+	int pool_sizes[64];
+	int pool_count = 0;
+
+	set_block_engine_threads(0); // all CPUs unless --threads is given
+	parse_threads_option(&argc,argv);
+	if((e_option = parse_value_option(&argc,argv,"--exponent")) != NULL){
+		e = parse_number_value("--exponent",e_option,0,ULONG_MAX);
+		if(e != 0 && (e < 3 || e % 2 == 0)){
+			fprintf(stderr,"The public exponent has to be an odd number greater than 2, or 0 for a random one\n");
+			exit(0);
+		}
+	}
+	if((bbs_option = parse_value_option(&argc,argv,"--bbs")) != NULL){
+		set_rsa_bbs_modulus_bits((int)parse_number_value("--bbs",bbs_option,0,INT_MAX));
+	}
+	if((value = parse_value_option(&argc,argv,"--pool-dir")) != NULL){
+		pool_dir = value;
+	}
+	if((value = parse_value_option(&argc,argv,"--watermark")) != NULL){
+		watermark = (int)parse_number_value("--watermark",value,1,INT_MAX);
+	}
+	if((pool_option = parse_value_option(&argc,argv,"--pool")) != NULL){// the pool service, sizes separated with commas
+		for(value = strtok(pool_option,","); value != NULL && pool_count < 64; value = strtok(NULL,","))
+			pool_sizes[pool_count++] = (int)parse_number_value("--pool",value,1,INT_MAX);
+		run_key_pool(pool_dir,pool_sizes,pool_count,e,watermark);
+	}
 	if(argc != 3 && argc != 2){
-		printf("Usage : ./create_rsa_keys username (key_bit_length) \nDefault key length is 1024bit");
+		printf("Usage : ./create_rsa_keys [--threads N] [--exponent e] [--bbs modulus_bits] [--pool-dir dir] username (key_bit_length) \n       ./create_rsa_keys [--pool-dir dir] [--watermark N] --pool key_bit_length[,key_bit_length...] \nDefault key length is 1024bit, default e is 65537, 0 is a random e, --bbs draws p and q from Blum Blum Shub\nWith --pool the keys are generated in the background into the pool, a ready pair in the pool is claimed instead of generating a new one");
 		exit(0);
 	}
 
@@ -25,8 +58,13 @@ int main(int argc,char** argv) {
 		key_length = atoi(argv[2]);
 	}
 
-	srand(time(NULL));
-	rsa_key_base* key_base = generate_rsa_key_base(key_length);
+	// a pre-generated pair, the pool does not use Blum Blum Shub
+	if(bbs_option == NULL && claim_pooled_keys(pool_dir,key_length,e,argv[1])){
+		printf("%dbit RSA keys for the %s user is taken from the key pool.\n",key_length,argv[1]);
+		return EXIT_SUCCESS;
+	}
+
+	rsa_key_base* key_base = generate_rsa_key_base_e(key_length,e);
 	rsa_keys* keys = create_pub_key(key_base);
 
 //	gmp_printf("p = %Zd\n",key_base->p);
@@ -43,7 +81,7 @@ int main(int argc,char** argv) {
 
 	printf("%dbit RSA keys for the %s user is generated.\n",key_length,argv[1]);
 
-	free(key_base);
-	free(keys);
+	free_rsa_key_base(key_base);
+	free_rsa_keys(keys);
 	return EXIT_SUCCESS;
 }
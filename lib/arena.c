@@ -0,0 +1,165 @@
+/**
+ * @file
+ * @brief Arena allocator of the threads.
+ */
+
+#include "arena.h"
+
+/**
+ * Key of the thread's arena.
+ */
+static pthread_key_t thread_arena_key;
+/**
+ * The key is created at the first use of an arena.
+ */
+static pthread_once_t thread_arena_once = PTHREAD_ONCE_INIT;
+
+/**
+ *
+ * @param size Bytes of data
+ * @return New chunk
+ *
+ * @brief Allocates a chunk with the given bytes of data.
+ */
+static arena_chunk* create_arena_chunk(size_t size){
+	arena_chunk* c = (arena_chunk*)malloc(sizeof(arena_chunk) + size);
+
+	if(c == NULL){
+		fprintf(stderr,"malloc Failed (create_arena_chunk)");
+		exit(0);
+	}
+	c->next = NULL;
+	c->size = size;
+	c->used = 0;
+	return c;
+}
+/**
+ *
+ * @param c The chunk
+ * @return First byte of the data of the chunk
+ */
+static char* arena_chunk_data(arena_chunk* c){
+	return (char*)(c + 1);
+}
+/**
+ *
+ * @param size Size of the first chunk, 0 for ARENA_CHUNK_SIZE
+ * @return Empty arena
+ *
+ * @brief Creates an empty arena.
+ */
+arena* create_arena(size_t size){
+	arena* a = (arena*)malloc(sizeof(arena));
+	int i;
+
+	a->first = create_arena_chunk(size > 0 ? size : ARENA_CHUNK_SIZE);
+	a->cur = a->first;
+	for(i = 0; i < ARENA_NUMS; i++)
+		mpz_init(a->num[i]);
+	return a;
+}
+/**
+ *
+ * @param a The arena
+ *
+ * @brief Frees the arena with all its chunks and its numbers.
+ */
+void free_arena(arena* a){
+	arena_chunk *c,*next;
+	int i;
+
+	for(i = 0; i < ARENA_NUMS; i++)
+		mpz_clear(a->num[i]);
+	for(c = a->first; c != NULL; c = next){
+		next = c->next;
+		free(c);
+	}
+	free(a);
+}
+/**
+ *
+ * @param a The arena
+ * @param size Bytes to allocate
+ * @return Allocated memory, aligned to ARENA_ALIGN
+ *
+ * @brief Bump allocation from the arena.
+ *
+ * When the current chunk is full the next chunk is used, the chunks stay in the arena after it goes back to a
+ * mark, so a message needs new chunks only for its first blocks. A chunk is added when the next one is too small.
+ */
+void* arena_alloc(arena* a,size_t size){
+	arena_chunk *c = a->cur,*n;
+	void* p;
+
+	size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+	if(c->size - c->used < size){
+		if(c->next != NULL && c->next->size >= size){
+			c = c->next;
+		}
+		else{
+			n = create_arena_chunk(size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE);
+			n->next = c->next;
+			c->next = n;
+			c = n;
+		}
+		c->used = 0;
+		a->cur = c;
+	}
+	p = arena_chunk_data(c) + c->used;
+	c->used += size;
+	return p;
+}
+/**
+ *
+ * @param a The arena
+ * @return Current position of the arena
+ */
+arena_mark arena_save(arena* a){
+	arena_mark mark;
+
+	mark.chunk = a->cur;
+	mark.used = a->cur->used;
+	return mark;
+}
+/**
+ *
+ * @param a The arena
+ * @param mark A position taken with arena_save
+ *
+ * @brief Frees everything allocated after the mark at once.
+ */
+void arena_restore(arena* a,arena_mark mark){
+	a->cur = mark.chunk;
+	a->cur->used = mark.used;
+}
+/**
+ *
+ * @param a The thread's arena
+ *
+ * @brief Frees the thread's arena when the thread exits.
+ */
+void thread_arena_destructor(void* a){
+	free_arena((arena*)a);
+}
+/**
+ * @brief Creates the key of the thread arenas.
+ */
+static void create_thread_arena_key(void){
+	pthread_key_create(&thread_arena_key,thread_arena_destructor);
+}
+/**
+ *
+ * @return The arena of the calling thread
+ *
+ * @brief Returns the thread's own arena, it is created at the first call of each thread.
+ */
+arena* get_thread_arena(void){
+	arena* a;
+
+	pthread_once(&thread_arena_once,create_thread_arena_key);
+	if((a = (arena*)pthread_getspecific(thread_arena_key)) == NULL){
+		a = create_arena(0);
+		pthread_setspecific(thread_arena_key,a);
+	}
+	return a;
+}
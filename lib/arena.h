@@ -0,0 +1,88 @@
+/**
+ * @file
+ * @brief Arena allocator for the scratch memory of a message and the GMP numbers of the blocks.
+ *
+ * The arena is a list of large chunks with a bump pointer. Each thread has its own arena, so there is no lock. The
+ * codec block arrays of a message and the limb scratch of the Montgomery exponentiations are taken from it with
+ * arena_alloc between arena_save and arena_restore, so they cost a pointer bump and are freed at once.
+ *
+ * GMP keeps allocating with malloc, realloc and free. The GMP temporaries of a block are the numbers of the thread's
+ * arena instead (see ARENA_NUMS): they are initialized once with the arena, grow to the size of the key at the first
+ * block and keep their limbs for the next blocks, so a block does not allocate. The arena of a thread and its
+ * numbers are freed when the thread exits, the workers of the block engine keep theirs for the life of the process.
+ * It is implemented in arena.c.
+ */
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <gmp.h>
+
+/**
+ * Size of a chunk of an arena, a larger allocation gets a chunk of its own size.
+ */
+#define ARENA_CHUNK_SIZE (256 << 10)
+/**
+ * Alignment of the allocations.
+ */
+#define ARENA_ALIGN 16
+/**
+ * Number read or built from a block, before the exponentiation.
+ */
+#define ARENA_NUM_BLOCK 0
+/**
+ * Result of the exponentiation of a block.
+ */
+#define ARENA_NUM_RESULT 1
+/**
+ * First of the three numbers of the CRT exponentiation (rsa_key_exp).
+ */
+#define ARENA_NUM_CRT 2
+/**
+ * Number of the GMP numbers of an arena.
+ */
+#define ARENA_NUMS 5
+
+/**
+ * @struct ARENA_CHUNK
+ * @brief ARENA_CHUNK is a piece of memory of an arena, the data follows the header.
+ */
+typedef struct ARENA_CHUNK {
+	struct ARENA_CHUNK* next; // next chunk, it is used after this one is full
+	size_t size; // bytes of data
+	size_t used; // bytes of data given out
+	size_t pad; // keeps the data aligned to ARENA_ALIGN
+}arena_chunk;
+
+/**
+ * @struct ARENA
+ * @brief ARENA is a bump allocator made of chunks.
+ */
+typedef struct ARENA {
+	arena_chunk* first; // first chunk
+	arena_chunk* cur; // chunk the allocations come from
+	mpz_t num[ARENA_NUMS]; // GMP temporaries of the thread, see ARENA_NUM_BLOCK
+}arena;
+
+/**
+ * @struct ARENA_MARK
+ * @brief ARENA_MARK is a position of an arena, the arena can go back to it.
+ */
+typedef struct ARENA_MARK {
+	arena_chunk* chunk; // current chunk at the time of the mark
+	size_t used; // used bytes of the chunk at the time of the mark
+}arena_mark;
+
+arena* create_arena(size_t size);
+void free_arena(arena* a);
+void* arena_alloc(arena* a,size_t size);
+arena_mark arena_save(arena* a);
+void arena_restore(arena* a,arena_mark mark);
+void thread_arena_destructor(void* a);
+arena* get_thread_arena(void);
+
+#endif /* ARENA_H_ */
@@ -0,0 +1,579 @@
+/**
+ * @file
+ * @brief Bit operations on integers and characters.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "bit_opts.h"
+
+/**
+ *
+ * @param c Input character
+ * @return The bits of the input character in a CHARBIT structure.
+ *
+ * @brief The function reveals the bits of the input character.
+ *
+ * The function extract the bits of the input character and put them into a CHARBIT structure for easy manipulation.
+ */
+charbit* char_to_bits(unsigned char c){
+	charbit* bitArr = (charbit*)malloc(sizeof(charbit));
+	unsigned char ch = (unsigned char)c;
+
+		bitArr->b0 = ch%2==1?1:0;
+		ch>>=1;
+		bitArr->b1 = ch%2==1?1:0;
+		ch>>=1;
+		bitArr->b2 = ch%2==1?1:0;
+		ch>>=1;
+		bitArr->b3 = ch%2==1?1:0;
+		ch>>=1;
+		bitArr->b4 = ch%2==1?1:0;
+		ch>>=1;
+		bitArr->b5 = ch%2==1?1:0;
+		ch>>=1;
+		bitArr->b6 = ch%2==1?1:0;
+		ch>>=1;
+		bitArr->b7 = ch%2==1?1:0;
+
+	return bitArr;
+}
+/**
+ *
+ * @param cb Character represented in bits as CHARBIT structure
+ * @return Character value
+ *
+ * @brief This function converts bit to character
+ *
+ * The function takes the bit representation in CHARBIT structure and turns them into the corresponding character.
+ */
+char bits_to_char(charbit* cb){
+	char a = 0;
+	if(cb->b0){
+		a=a^1;
+	}
+	if(cb->b1){
+		a=a^2;
+	}
+	if(cb->b2){
+		a=a^4;
+	}
+	if(cb->b3){
+		a=a^8;
+	}
+	if(cb->b4){
+		a=a^16;
+	}
+	if(cb->b5){
+		a=a^32;
+	}
+	if(cb->b6){
+		a=a^64;
+	}
+	if(cb->b7){
+		a=a^128;
+	}
+
+	return a;
+}
+/**
+ *
+ * @param cb Character represented in bits as CHARBIT structure
+ * @param i Index of the bit that will be gotten.
+ * @return Bit value of the given bit index.
+ *
+ * @brief Reveals the bit value at the given index.
+ *
+ * The function reveals the bit value of the given character given as CHARBIT structure at the given index.
+ */
+int getbit_of_charbit(charbit* cb,int i){
+	if(i == 0){
+		return cb->b0;
+	}else if(i == 1){
+		return cb->b1;
+	}else if(i == 2){
+		return cb->b2;
+	}else if(i == 3){
+		return cb->b3;
+	}else if(i == 4){
+		return cb->b4;
+	}else if(i == 5){
+		return cb->b5;
+	}else if(i == 6){
+		return cb->b6;
+	}else if(i == 7){
+		return cb->b7;
+	}
+	else {
+		printf("No index to get 0-7 exiting...\n");
+		exit(0);
+	}
+	return 0;
+}
+/**
+ *
+ * @param cb Character represented in bits as CHARBIT structure
+ * @param i Index of the bit that will be manipulated
+ * @param setbit New bit value.
+ *
+ * @brief The function does the manipulation at the given index of the character.
+ *
+ * This function enables us to manipulate the bits of the given character as CHARBIT.
+ */
+void setbit_of_charbit(charbit* cb,unsigned int i,unsigned int setbit){
+	if(i == 0){
+		cb->b0 = setbit % 2;
+	}else if(i == 1){
+		cb->b1 = setbit % 2;
+	}else if(i == 2){
+		cb->b2 = setbit % 2;
+	}else if(i == 3){
+		cb->b3 = setbit % 2;
+	}else if(i == 4){
+		cb->b4 = setbit % 2;
+	}else if(i == 5){
+		cb->b5 = setbit % 2;
+	}else if(i == 6){
+		cb->b6 = setbit % 2;
+	}else if(i == 7){
+		cb->b7 = setbit % 2;
+	}
+	else {
+		printf("No index to get 0-7 exiting...\n");
+		exit(0);
+	}
+}
+/**
+ *
+ * @param bin_num Integer represented in bits as INTBIT structure
+ * @param i Index of the bit that will be manipulated
+ * @param setbit New bit value
+ *
+ * @brief The function does the manipulation at the given index of the integer.
+ *
+ * This function enables us to manipulate the bits of the given integer as INTBIT.
+ */
+void setbit_of_intbit(intbit* bin_num,unsigned int i,unsigned int setbit){
+	if(i == 0){
+		bin_num->b0 = setbit % 2;
+	}else if(i == 1){
+		bin_num->b1 = setbit % 2;
+	}else if(i == 2){
+		bin_num->b2 = setbit % 2;
+	}else if(i == 3){
+		bin_num->b3 = setbit % 2;
+	}else if(i == 4){
+		bin_num->b4 = setbit % 2;
+	}else if(i == 5){
+		bin_num->b5 = setbit % 2;
+	}else if(i == 6){
+		bin_num->b6 = setbit % 2;
+	}else if(i == 7){
+		bin_num->b7 = setbit % 2;
+	}else if(i == 8){
+		bin_num->b8 = setbit % 2;
+	}else if(i == 9){
+		bin_num->b9 = setbit % 2;
+	}else if(i == 10){
+		bin_num->b10 = setbit % 2;
+	}else if(i == 11){
+		bin_num->b11 = setbit % 2;
+	}else if(i == 12){
+		bin_num->b12 = setbit % 2;
+	}else if(i == 13){
+		bin_num->b13 = setbit % 2;
+	}else if(i == 14){
+		bin_num->b14 = setbit % 2;
+	}else if(i == 15){
+		bin_num->b15 = setbit % 2;
+	}else if(i == 16){
+		bin_num->b16 = setbit % 2;
+	}else if(i == 17){
+		bin_num->b17 = setbit % 2;
+	}else if(i == 18){
+		bin_num->b18 = setbit % 2;
+	}else if(i == 19){
+		bin_num->b19 = setbit % 2;
+	}else if(i == 20){
+		bin_num->b20 = setbit % 2;
+	}else if(i == 21){
+		bin_num->b21 = setbit % 2;
+	}else if(i == 22){
+		bin_num->b22 = setbit % 2;
+	}else if(i == 23){
+		bin_num->b23 = setbit % 2;
+	}else if(i == 24){
+		bin_num->b24 = setbit % 2;
+	}else if(i == 25){
+		bin_num->b25 = setbit % 2;
+	}else if(i == 26){
+		bin_num->b26 = setbit % 2;
+	}else if(i == 27){
+		bin_num->b27 = setbit % 2;
+	}else if(i == 28){
+		bin_num->b28 = setbit % 2;
+	}else if(i == 29){
+		bin_num->b29 = setbit % 2;
+	}else if(i == 30){
+		bin_num->b30 = setbit % 2;
+	}else if(i == 31){
+		bin_num->b31 = setbit % 2;
+	}
+	else{
+		printf("No index to get 0-31 exiting...\n");
+		exit(0);
+	}
+}
+/**
+ *
+ * @param bin_num Integer represented in bits as INTBIT structure
+ * @param i Index of the bit that will be gotten
+ * @return Bit value at the given bit index.
+ *
+ * @brief Reveals the bit value at the given index.
+ *
+ * The function reveals the bit value of the given integer given as INTBIT structure at the given index.
+ */
+int getbit_of_intbit(intbit* bin_num,int i){
+	if(i == 0){
+		return bin_num->b0;
+	}else if(i == 1){
+		return bin_num->b1;
+	}else if(i == 2){
+		return bin_num->b2;
+	}else if(i == 3){
+		return bin_num->b3;
+	}else if(i == 4){
+		return bin_num->b4;
+	}else if(i == 5){
+		return bin_num->b5;
+	}else if(i == 6){
+		return bin_num->b6;
+	}else if(i == 7){
+		return bin_num->b7;
+	}else if(i == 8){
+		return bin_num->b8;
+	}else if(i == 9){
+		return bin_num->b9;
+	}else if(i == 10){
+		return bin_num->b10;
+	}else if(i == 11){
+		return bin_num->b11;
+	}else if(i == 12){
+		return bin_num->b12;
+	}else if(i == 13){
+		return bin_num->b13;
+	}else if(i == 14){
+		return bin_num->b14;
+	}else if(i == 15){
+		return bin_num->b15;
+	}else if(i == 16){
+		return bin_num->b16;
+	}else if(i == 17){
+		return bin_num->b17;
+	}else if(i == 18){
+		return bin_num->b18;
+	}else if(i == 19){
+		return bin_num->b19;
+	}else if(i == 20){
+		return bin_num->b20;
+	}else if(i == 21){
+		return bin_num->b21;
+	}else if(i == 22){
+		return bin_num->b22;
+	}else if(i == 23){
+		return bin_num->b23;
+	}else if(i == 24){
+		return bin_num->b24;
+	}else if(i == 25){
+		return bin_num->b25;
+	}else if(i == 26){
+		return bin_num->b26;
+	}else if(i == 27){
+		return bin_num->b27;
+	}else if(i == 28){
+		return bin_num->b28;
+	}else if(i == 29){
+		return bin_num->b29;
+	}else if(i == 30){
+		return bin_num->b30;
+	}else if(i == 31){
+		return bin_num->b31;
+	}
+	else{
+		printf("No index to set 0-31 exiting...\n");
+		exit(0);
+	}
+}
+/**
+ *
+ * @param bin_num Integer represented in bits as INTBIT structure
+ * @brief Prints the bits of INTBIT structure on the screen
+ *
+ * This function is not used in the project. It is put for the debugging purposes.
+ */
+void print_bits_of_intbits(intbit* bin_num){
+	int i;
+	for (i = INTBITLENGTH-1; i >= 0; --i) {
+		printf("%d ",getbit_of_intbit(bin_num,i));
+	}
+	printf("\n");
+}
+/**
+ *
+ * @param x Input integer
+ * @return The bits of the input integer in a INTBIT structure.
+ *
+ * @brief The function reveals the bits of the input integer.
+ *
+ * The function extract the bits of the input integer and put them into a INTBIT structure for easy manipulation.
+ */
+intbit* int_to_bits(unsigned int x){
+	intbit* bin_num = (intbit*)malloc(sizeof(intbit));
+	unsigned int ch = x;
+	int i;
+
+	for(i = 0; i < INTBITLENGTH; ++i){
+		setbit_of_intbit(bin_num,i,ch%2==1?1:0);
+		ch>>=1;
+	}
+
+	return bin_num;
+}
+/**
+ *
+ * @param bin_num Integer represented in bits as INTBIT structure
+ * @return Integer value
+ *
+ * @brief This function converts bit to integer
+ *
+ * The function takes the bit representation in INTBIT structure and turns them into the corresponding integer.
+ *
+ */
+unsigned int bits_to_int(intbit* bin_num){
+	int i;
+	unsigned int dec_num = 0;
+
+	for(i = 0; i<INTBITLENGTH; i++){
+		dec_num += (getbit_of_intbit(bin_num,i) * pow(2.0,(double)i));
+	}
+
+	return dec_num;
+}
+/**
+ *
+ * @param str Input string
+ * @param size Size of the string
+ * @return The last characters index
+ */
+int find_right_most_char(char* str,int size){
+	int i;
+	for (i = 0; i < size; ++i) {
+		if(str[i] == '\0')
+			return i == 0 ? 0 : i-1;
+	}
+	return size-1;
+}
+/**
+ *
+ * @param str Input string
+ * @return Compressed integer value
+ *
+ * @brief The function does the compression on the given 4 characters.
+ *
+ * The compression that compresses 4 characters into an integer is done in this function.
+ * The characters are the bytes of the integer, the first one is the most significant byte. The characters after a
+ * termination char are taken as zeros.
+ */
+int compress_chars_to_int(char* str){ // every time it will get 4 characters
+	int i;
+	unsigned int res = 0;
+
+	for (i = 0; i < 4 && str[i] != '\0'; ++i) {
+		res |= (unsigned int)(unsigned char)str[i] << (8*(3-i));
+	}
+	return (int)res;
+}
+/**
+ *
+ * @param x Compressed integer
+ * @return Decompressed characters
+ *
+ * @brief Decompresses the integer to its initial character values.
+ *
+ * The decompression is done in this function. The bytes of the integer are the 4 characters, the most significant
+ * one is the first character.
+ */
+char* decompress_int_to_char(unsigned int x){
+	char* str = (char*)malloc(4*sizeof(char));
+
+	unpack_char_blocks((const uint32_t*)&x,1,str);
+	return str;
+}
+/**
+ *
+ * @param in 4 byte words
+ * @param out Output words, may be the same with in
+ * @param count Number of words
+ *
+ * @brief Portable byte swap of 4 byte words.
+ */
+static void swap_char_blocks_generic(const void* in,void* out,size_t count){
+	const unsigned char* src = (const unsigned char*)in;
+	unsigned char* dst = (unsigned char*)out;
+	uint32_t w;
+	size_t i;
+
+	for (i = 0; i < count; ++i) {
+		memcpy(&w,src+(i*4),4);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		w = __builtin_bswap32(w);
+#endif
+		memcpy(dst+(i*4),&w,4);
+	}
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+/**
+ *
+ * @param in 4 byte words
+ * @param out Output words, may be the same with in
+ * @param count Number of words
+ *
+ * @brief Byte swap of 4 byte words with the SSSE3 byte shuffle, 16 words in a loop.
+ */
+__attribute__((target("ssse3")))
+static void swap_char_blocks_ssse3(const void* in,void* out,size_t count){
+	const unsigned char* src = (const unsigned char*)in;
+	unsigned char* dst = (unsigned char*)out;
+	const __m128i mask = _mm_set_epi8(12,13,14,15,8,9,10,11,4,5,6,7,0,1,2,3);
+	__m128i a,b,c,d;
+	size_t i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		a = _mm_loadu_si128((const __m128i*)(src+(i*4)));
+		b = _mm_loadu_si128((const __m128i*)(src+(i*4)+16));
+		c = _mm_loadu_si128((const __m128i*)(src+(i*4)+32));
+		d = _mm_loadu_si128((const __m128i*)(src+(i*4)+48));
+		_mm_storeu_si128((__m128i*)(dst+(i*4)),_mm_shuffle_epi8(a,mask));
+		_mm_storeu_si128((__m128i*)(dst+(i*4)+16),_mm_shuffle_epi8(b,mask));
+		_mm_storeu_si128((__m128i*)(dst+(i*4)+32),_mm_shuffle_epi8(c,mask));
+		_mm_storeu_si128((__m128i*)(dst+(i*4)+48),_mm_shuffle_epi8(d,mask));
+	}
+	for (; i + 4 <= count; i += 4) {
+		a = _mm_loadu_si128((const __m128i*)(src+(i*4)));
+		_mm_storeu_si128((__m128i*)(dst+(i*4)),_mm_shuffle_epi8(a,mask));
+	}
+	swap_char_blocks_generic(src+(i*4),dst+(i*4),count-i);
+}
+
+/**
+ * @return The byte swap function for this processor
+ */
+static void (*select_swap_char_blocks(void))(const void*,void*,size_t){
+	unsigned int a,b,c,d;
+
+	if(__get_cpuid(1,&a,&b,&c,&d) && ((c >> 9) & 1))
+		return swap_char_blocks_ssse3;
+	return swap_char_blocks_generic;
+}
+
+#elif defined(__aarch64__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+
+#include <arm_neon.h>
+
+/**
+ *
+ * @param in 4 byte words
+ * @param out Output words, may be the same with in
+ * @param count Number of words
+ *
+ * @brief Byte swap of 4 byte words with the NEON byte reverse, 4 words in a loop.
+ */
+static void swap_char_blocks_neon(const void* in,void* out,size_t count){
+	const unsigned char* src = (const unsigned char*)in;
+	unsigned char* dst = (unsigned char*)out;
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		vst1q_u8(dst+(i*4),vrev32q_u8(vld1q_u8(src+(i*4))));
+	}
+	swap_char_blocks_generic(src+(i*4),dst+(i*4),count-i);
+}
+
+/**
+ * @return The byte swap function for this processor
+ */
+static void (*select_swap_char_blocks(void))(const void*,void*,size_t){
+	return swap_char_blocks_neon;
+}
+
+#else
+
+/**
+ * @return The byte swap function for this processor
+ */
+static void (*select_swap_char_blocks(void))(const void*,void*,size_t){
+	return swap_char_blocks_generic;
+}
+
+#endif
+
+/**
+ * The byte swap function used by pack_char_blocks and unpack_char_blocks, it is chosen when the program starts.
+ */
+static void (*swap_char_blocks)(const void*,void*,size_t) = swap_char_blocks_generic;
+
+/**
+ * @brief Chooses the byte swap function for the processor.
+ */
+__attribute__((constructor))
+static void init_swap_char_blocks(void){
+	swap_char_blocks = select_swap_char_blocks();
+}
+/**
+ *
+ * @param m Plain text
+ * @param m_size Size of the plain text
+ * @param blocks Output, (m_size+3)/4 compressed blocks
+ * @return Number of blocks
+ *
+ * @brief Compresses the whole plain text to its 4 character blocks.
+ *
+ * Each block has the same value with compress_chars_to_int of its 4 characters. The plain text has no termination
+ * char in it, the missing characters of the last block are zeros. The full blocks are byte swapped at once, there is
+ * no allocation.
+ */
+size_t pack_char_blocks(const char* m,size_t m_size,uint32_t* blocks){
+	size_t full = m_size/4;
+	size_t rest = m_size%4;
+	size_t i;
+
+	swap_char_blocks(m,blocks,full);
+	if(rest > 0){
+		blocks[full] = 0;
+		for (i = 0; i < rest; ++i) {
+			blocks[full] |= (uint32_t)(unsigned char)m[(full*4)+i] << (8*(3-i));
+		}
+		full++;
+	}
+	return full;
+}
+/**
+ *
+ * @param blocks Compressed blocks
+ * @param count Number of blocks
+ * @param out Output, 4*count characters
+ *
+ * @brief Decompresses the blocks to their characters.
+ *
+ * The characters of each block are the same with decompress_int_to_char, they are written one after another.
+ */
+void unpack_char_blocks(const uint32_t* blocks,size_t count,char* out){
+	swap_char_blocks(blocks,out,count);
+}
@@ -0,0 +1,239 @@
+/**
+ * @file
+ * @brief Thread pool of the block engine.
+ */
+
+#include "block_engine.h"
+
+int block_engine_threads = 1;
+
+/**
+ * Lock of the pool, it protects the queue, the thread count and the jobs.
+ */
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+/**
+ * Signaled when a job is put in the queue.
+ */
+static pthread_cond_t pool_work = PTHREAD_COND_INITIALIZER;
+/**
+ * First and last jobs that still have blocks to take.
+ */
+static block_engine *pool_head = NULL,*pool_tail = NULL;
+/**
+ * Number of the started worker threads.
+ */
+static int pool_threads = 0;
+
+/**
+ *
+ * @param n Number of threads, 0 means one thread for each online CPU
+ *
+ * @brief Sets the number of worker threads of the block engine.
+ */
+void set_block_engine_threads(int n){
+	if(n <= 0)
+		n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if(n <= 0)
+		n = 1;
+	if(n > BLOCK_ENGINE_MAX_THREADS)
+		n = BLOCK_ENGINE_MAX_THREADS;
+	block_engine_threads = n;
+}
+/**
+ *
+ * @param e The job
+ * @param start Output, first block of the range
+ * @param end Output, block after the range
+ * @return true(1) if a range is taken, false(0) if all the blocks of the job are taken
+ *
+ * @brief Takes the next BLOCK_ENGINE_RANGE blocks of the job, the lock of the pool is held by the caller.
+ *
+ * The job leaves the queue with its last range, so every job of the queue has blocks to take.
+ */
+int take_block_range(block_engine* e,size_t* start,size_t* end){
+	block_engine *q,*prev = NULL;
+
+	if(e->next >= e->count)
+		return 0;
+	*start = e->next;
+	*end = *start + BLOCK_ENGINE_RANGE < e->count ? *start + BLOCK_ENGINE_RANGE : e->count;
+	e->next = *end;
+	if(e->next >= e->count){// the last range, the job leaves the queue
+		for(q = pool_head; q != e; q = q->queued)
+			prev = q;
+		if(prev == NULL)
+			pool_head = e->queued;
+		else
+			prev->queued = e->queued;
+		if(pool_tail == e)
+			pool_tail = prev;
+	}
+	return 1;
+}
+/**
+ *
+ * @param e The job
+ * @param start First block of the range
+ * @param end Block after the range
+ *
+ * @brief Processes the range without the lock and counts its blocks as finished, the lock is held before and after.
+ */
+void finish_block_range(block_engine* e,size_t start,size_t end){
+	size_t i;
+
+	pthread_mutex_unlock(&pool_lock);
+	for(i = start; i < end; i++)
+		e->f(i,e->arg);
+	pthread_mutex_lock(&pool_lock);
+
+	e->done += end - start;
+	if(e->done == e->count)
+		pthread_cond_signal(&e->finished);
+}
+/**
+ *
+ * @param unused Not used
+ * @return Never returns
+ *
+ * @brief Worker thread of the pool.
+ *
+ * Waits for a job in the queue and processes ranges of the first job until the queue is empty. The worker threads,
+ * with their arenas and random sources, live until the process ends.
+ */
+void* block_engine_worker(void* unused){
+	block_engine* e;
+	size_t start,end;
+
+	(void)unused;
+	pthread_mutex_lock(&pool_lock);
+	while(1){
+		while(pool_head == NULL)
+			pthread_cond_wait(&pool_work,&pool_lock);
+		e = pool_head;
+		if(take_block_range(e,&start,&end))
+			finish_block_range(e,start,end);
+	}
+	return NULL;
+}
+/**
+ *
+ * @param n Number of worker threads the pool needs
+ *
+ * @brief Starts the worker threads that the pool does not have yet, the lock of the pool is held by the caller.
+ *
+ * The pool only grows, a smaller block_engine_threads later leaves the started threads waiting for jobs.
+ */
+void start_block_engine_pool(int n){
+	pthread_t thread;
+
+	for(; pool_threads < n; pool_threads++){
+		if(pthread_create(&thread,NULL,block_engine_worker,NULL) != 0){
+			fprintf(stderr,"pthread_create failed (start_block_engine_pool)\n");
+			exit(0);
+		}
+		pthread_detach(thread);
+	}
+}
+/**
+ *
+ * @param count Number of blocks
+ * @param f Function called for each block
+ * @param arg Argument passed to f
+ *
+ * @brief Calls f for each block index from 0 to count-1 on the worker threads.
+ *
+ * The function returns when all the blocks are processed. With one thread, or a single range of blocks,
+ * everything is done on the calling thread. Otherwise the job is put in the queue of the pool, which has
+ * block_engine_threads - 1 workers, and the calling thread takes ranges of it like a worker.
+ */
+void run_block_engine(size_t count,block_func f,void* arg){
+	size_t ranges = (count + BLOCK_ENGINE_RANGE - 1) / BLOCK_ENGINE_RANGE;
+	size_t start,end;
+	block_engine e;
+
+	if(block_engine_threads <= 1 || ranges <= 1){
+		for(start = 0; start < count; start++)
+			f(start,arg);
+		return;
+	}
+
+	e.next = 0;
+	e.count = count;
+	e.done = 0;
+	e.f = f;
+	e.arg = arg;
+	e.queued = NULL;
+	pthread_cond_init(&e.finished,NULL);
+
+	pthread_mutex_lock(&pool_lock);
+	start_block_engine_pool(block_engine_threads - 1);
+	if(pool_tail != NULL)
+		pool_tail->queued = &e;
+	else
+		pool_head = &e;
+	pool_tail = &e;
+	if(ranges - 1 < (size_t)block_engine_threads - 1)// only as many workers as the ranges left for them
+		for(start = 0; start < ranges - 1; start++)
+			pthread_cond_signal(&pool_work);
+	else
+		pthread_cond_broadcast(&pool_work);
+
+	while(take_block_range(&e,&start,&end))
+		finish_block_range(&e,start,end);
+	while(e.done < e.count)
+		pthread_cond_wait(&e.finished,&pool_lock);
+	pthread_mutex_unlock(&pool_lock);
+
+	pthread_cond_destroy(&e.finished);
+}
+/**
+ *
+ * @param option Name of the option, for the error message
+ * @param value Value of the option
+ * @param min Smallest accepted value
+ * @param max Largest accepted value
+ * @return The value as a number
+ *
+ * @brief Reads the decimal value of a numeric option, the program exits when it is not a number in the range.
+ *
+ * Only decimal digits are accepted, so a value like "abc" or "12x" is not read as 0 or 12 the way atoi reads it.
+ */
+unsigned long parse_number_value(char* option,char* value,unsigned long min,unsigned long max){
+	unsigned long n;
+	char* end;
+
+	errno = 0;
+	n = strtoul(value,&end,10);
+	if(value[0] < '0' || value[0] > '9' || *end != '\0' || errno == ERANGE || n < min || n > max){
+		fprintf(stderr,"%s needs a number from %lu to %lu, \"%s\" is given\n",option,min,max,value);
+		exit(0);
+	}
+	return n;
+}
+/**
+ *
+ * @param argc Argument count, the option is removed from it
+ * @param argv Arguments, the option is removed from them
+ *
+ * @brief Reads the "--threads N" option of the programs and sets the number of worker threads.
+ *
+ * The option and its value are removed from the arguments, so the programs can check the remaining
+ * arguments as before. N has to be a positive number, more threads than BLOCK_ENGINE_MAX_THREADS are cut down to it.
+ */
+void parse_threads_option(int* argc,char** argv){
+	int i,j;
+
+	for(i = 1; i < *argc; i++){
+		if(strcmp(argv[i],"--threads") == 0){
+			if(i + 1 >= *argc){
+				fprintf(stderr,"--threads needs a number\n");
+				exit(0);
+			}
+			set_block_engine_threads((int)parse_number_value("--threads",argv[i+1],1,INT_MAX));
+			for(j = i; j + 2 < *argc; j++)
+				argv[j] = argv[j+2];
+			*argc -= 2;
+			return;
+		}
+	}
+}
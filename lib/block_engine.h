@@ -0,0 +1,72 @@
+/**
+ * @file
+ * @brief Multi-threaded engine for the independent blocks of a message.
+ *
+ * The RSA blocks of a message do not depend on each other, so they are processed by a pool of worker threads.
+ * The workers take ranges of block indexes until all blocks are done. Each block writes its own result slot,
+ * so the output keeps the order of the blocks. The GMP temporaries of a block are the numbers of the worker's arena
+ * (see arena.h).
+ *
+ * The pool is started at the first run_block_engine that needs more than one thread and lives for the rest of the
+ * process, so a message that runs the engine many times, for each chunk of the fused encryption or each level of a
+ * Merkle tree, does not create threads or their arenas and random sources again. The jobs are handed to the workers
+ * through a queue, and the calling thread works on its own job too.
+ */
+
+#ifndef BLOCK_ENGINE_H_
+#define BLOCK_ENGINE_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include "arena.h"
+
+/**
+ * Number of blocks a worker takes at a time.
+ */
+#define BLOCK_ENGINE_RANGE 8
+/**
+ * Upper limit for the number of worker threads.
+ */
+#define BLOCK_ENGINE_MAX_THREADS 256
+
+/**
+ * Number of worker threads used by run_block_engine.
+ */
+extern int block_engine_threads;
+
+/**
+ * Function that processes the block with the given index.
+ */
+typedef void (*block_func)(size_t i, void* arg);
+
+/**
+ * @struct BLOCK_ENGINE
+ * @brief BLOCK_ENGINE is a job of the pool, the state of one run_block_engine call shared by the worker threads.
+ *
+ * The fields are protected by the lock of the pool.
+ */
+typedef struct BLOCK_ENGINE {
+	size_t next; // index of the next block that is not taken yet
+	size_t count; // total number of blocks
+	size_t done; // number of the finished blocks
+	block_func f; // function called for each block
+	void* arg; // argument passed to f
+	pthread_cond_t finished; // signaled when all the blocks are finished
+	struct BLOCK_ENGINE* queued; // next job in the queue
+}block_engine;
+
+void set_block_engine_threads(int n);
+unsigned long parse_number_value(char* option,char* value,unsigned long min,unsigned long max);
+int take_block_range(block_engine* e,size_t* start,size_t* end);
+void finish_block_range(block_engine* e,size_t start,size_t end);
+void* block_engine_worker(void* unused);
+void start_block_engine_pool(int n);
+void run_block_engine(size_t count,block_func f,void* arg);
+void parse_threads_option(int* argc,char** argv);
+
+#endif /* BLOCK_ENGINE_H_ */
@@ -0,0 +1,187 @@
+/**
+ * @file
+ * @brief ChaCha20 block function and key stream.
+ */
+
+#include "chacha20.h"
+
+#define CHACHA20_ROTL(x,n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+#define CHACHA20_QR(a,b,c,d)                    \
+{                                               \
+a += b; d ^= a; d = CHACHA20_ROTL(d,16);        \
+c += d; b ^= c; b = CHACHA20_ROTL(b,12);        \
+a += b; d ^= a; d = CHACHA20_ROTL(d, 8);        \
+c += d; b ^= c; b = CHACHA20_ROTL(b, 7);        \
+}
+
+/**
+ *
+ * @param b Input bytes
+ * @return Little endian 32 bit number
+ */
+uint32_t chacha20_load32(const unsigned char* b){
+	return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+/**
+ *
+ * @param b Output bytes
+ * @param x Number to write as little endian
+ */
+void chacha20_store32(unsigned char* b,uint32_t x){
+	b[0] = (unsigned char)x;
+	b[1] = (unsigned char)(x >> 8);
+	b[2] = (unsigned char)(x >> 16);
+	b[3] = (unsigned char)(x >> 24);
+}
+/**
+ *
+ * @param ctx The cipher
+ * @param key 32 byte key
+ * @param nonce 12 byte nonce
+ * @param counter Initial block counter
+ *
+ * @brief Sets up the cipher with the key and the nonce.
+ */
+void chacha20_init(chacha20_ctx* ctx,const unsigned char* key,const unsigned char* nonce,uint32_t counter){
+	int i;
+
+	ctx->state[0] = 0x61707865; // "expand 32-byte k"
+	ctx->state[1] = 0x3320646e;
+	ctx->state[2] = 0x79622d32;
+	ctx->state[3] = 0x6b206574;
+	for(i = 0; i < 8; i++)
+		ctx->state[4+i] = chacha20_load32(key + 4*i);
+	ctx->state[12] = counter;
+	for(i = 0; i < 3; i++)
+		ctx->state[13+i] = chacha20_load32(nonce + 4*i);
+	ctx->pos = CHACHA20_BLOCK_SIZE; // no key stream yet
+}
+/**
+ *
+ * @param ctx The cipher
+ * @param out 64 bytes of key stream
+ *
+ * @brief Computes the key stream block of the current counter and increments the counter.
+ */
+void chacha20_block(chacha20_ctx* ctx,unsigned char* out){
+	uint32_t x[16];
+	int i;
+
+	memcpy(x,ctx->state,sizeof(x));
+	for(i = 0; i < 10; i++){// 20 rounds, a column and a diagonal round in each step
+		CHACHA20_QR(x[0],x[4],x[ 8],x[12]);
+		CHACHA20_QR(x[1],x[5],x[ 9],x[13]);
+		CHACHA20_QR(x[2],x[6],x[10],x[14]);
+		CHACHA20_QR(x[3],x[7],x[11],x[15]);
+		CHACHA20_QR(x[0],x[5],x[10],x[15]);
+		CHACHA20_QR(x[1],x[6],x[11],x[12]);
+		CHACHA20_QR(x[2],x[7],x[ 8],x[13]);
+		CHACHA20_QR(x[3],x[4],x[ 9],x[14]);
+	}
+	for(i = 0; i < 16; i++)
+		chacha20_store32(out + 4*i,x[i] + ctx->state[i]);
+	ctx->state[12]++;
+}
+/**
+ * Vector of 4 numbers, one for each of 4 blocks computed together.
+ */
+typedef uint32_t chacha20_vec __attribute__((vector_size(16)));
+
+/**
+ *
+ * @param ctx The cipher
+ * @param out 256 bytes of key stream
+ *
+ * @brief Computes 4 key stream blocks at once and increments the counter by 4.
+ *
+ * Each word of the state is a vector with one number for each block, so the rounds of the 4 blocks are done
+ * with the same vector instructions. The blocks only differ in their counters.
+ */
+void chacha20_block4(chacha20_ctx* ctx,unsigned char* out){
+	chacha20_vec x[16],s[16];
+	int i,j;
+
+	for(i = 0; i < 16; i++){
+		for(j = 0; j < 4; j++)
+			s[i][j] = ctx->state[i];
+	}
+	for(j = 0; j < 4; j++)
+		s[12][j] += j;
+	memcpy(x,s,sizeof(x));
+
+	for(i = 0; i < 10; i++){
+		CHACHA20_QR(x[0],x[4],x[ 8],x[12]);
+		CHACHA20_QR(x[1],x[5],x[ 9],x[13]);
+		CHACHA20_QR(x[2],x[6],x[10],x[14]);
+		CHACHA20_QR(x[3],x[7],x[11],x[15]);
+		CHACHA20_QR(x[0],x[5],x[10],x[15]);
+		CHACHA20_QR(x[1],x[6],x[11],x[12]);
+		CHACHA20_QR(x[2],x[7],x[ 8],x[13]);
+		CHACHA20_QR(x[3],x[4],x[ 9],x[14]);
+	}
+	for(i = 0; i < 16; i++){
+		x[i] += s[i];
+		for(j = 0; j < 4; j++)
+			chacha20_store32(out + CHACHA20_BLOCK_SIZE*j + 4*i,x[i][j]);
+	}
+	ctx->state[12] += 4;
+}
+/**
+ *
+ * @param ctx The cipher
+ * @param in Input data
+ * @param out Output data, it can be the same with the input
+ * @param len Size of the data
+ *
+ * @brief Encrypts or decrypts the data by xoring it with the key stream.
+ *
+ * The cipher keeps its place in the key stream, so a message can be processed in pieces of any size.
+ * Most of the key stream is computed 4 blocks at a time and xored 8 bytes at a time.
+ */
+void chacha20_xor(chacha20_ctx* ctx,const unsigned char* in,unsigned char* out,size_t len){
+	unsigned char ks[4*CHACHA20_BLOCK_SIZE];
+	uint64_t a,b;
+	size_t i;
+
+	// use the rest of the last key stream block
+	while(len > 0 && ctx->pos < CHACHA20_BLOCK_SIZE){
+		*out++ = *in++ ^ ctx->keystream[ctx->pos++];
+		len--;
+	}
+	// 4 whole blocks at a time
+	while(len >= 4*CHACHA20_BLOCK_SIZE){
+		chacha20_block4(ctx,ks);
+		for(i = 0; i < 4*CHACHA20_BLOCK_SIZE; i += 8){
+			memcpy(&a,in + i,8);
+			memcpy(&b,ks + i,8);
+			a ^= b;
+			memcpy(out + i,&a,8);
+		}
+		in += 4*CHACHA20_BLOCK_SIZE;
+		out += 4*CHACHA20_BLOCK_SIZE;
+		len -= 4*CHACHA20_BLOCK_SIZE;
+	}
+	// whole blocks
+	while(len >= CHACHA20_BLOCK_SIZE){
+		chacha20_block(ctx,ctx->keystream);
+		for(i = 0; i < CHACHA20_BLOCK_SIZE; i += 8){
+			memcpy(&a,in + i,8);
+			memcpy(&b,ctx->keystream + i,8);
+			a ^= b;
+			memcpy(out + i,&a,8);
+		}
+		in += CHACHA20_BLOCK_SIZE;
+		out += CHACHA20_BLOCK_SIZE;
+		len -= CHACHA20_BLOCK_SIZE;
+	}
+	// start a new block for the rest
+	if(len > 0){
+		chacha20_block(ctx,ctx->keystream);
+		ctx->pos = 0;
+		while(len > 0){
+			*out++ = *in++ ^ ctx->keystream[ctx->pos++];
+			len--;
+		}
+	}
+}
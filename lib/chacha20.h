@@ -0,0 +1,45 @@
+/**
+ * @file
+ * @brief ChaCha20 stream cipher.
+ *
+ * The ChaCha20 stream cipher as described in RFC 8439, with a 256 bit key, a 96 bit nonce and a 32 bit block counter.
+ * It is used to encrypt the body of the messages in the hybrid mode, where only the session key is encrypted with RSA.
+ */
+
+#ifndef CHACHA20_H_
+#define CHACHA20_H_
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Size of a ChaCha20 key in bytes.
+ */
+#define CHACHA20_KEY_SIZE 32
+/**
+ * Size of a ChaCha20 nonce in bytes.
+ */
+#define CHACHA20_NONCE_SIZE 12
+/**
+ * Size of a ChaCha20 key stream block in bytes.
+ */
+#define CHACHA20_BLOCK_SIZE 64
+
+/**
+ * @struct CHACHA20_CTX
+ * @brief CHACHA20_CTX holds the state of the cipher and the unused part of the last key stream block.
+ */
+typedef struct CHACHA20_CTX {
+	uint32_t state[16]; // constants, key, block counter and nonce
+	unsigned char keystream[CHACHA20_BLOCK_SIZE]; // last key stream block
+	size_t pos; // used bytes of the last key stream block
+}chacha20_ctx;
+
+uint32_t chacha20_load32(const unsigned char* b);
+void chacha20_store32(unsigned char* b,uint32_t x);
+void chacha20_init(chacha20_ctx* ctx,const unsigned char* key,const unsigned char* nonce,uint32_t counter);
+void chacha20_block(chacha20_ctx* ctx,unsigned char* out);
+void chacha20_block4(chacha20_ctx* ctx,unsigned char* out);
+void chacha20_xor(chacha20_ctx* ctx,const unsigned char* in,unsigned char* out,size_t len);
+
+#endif /* CHACHA20_H_ */
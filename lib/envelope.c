@@ -0,0 +1,217 @@
+/**
+ * @file
+ * @brief Building, parsing and authenticating the message envelopes.
+ */
+
+#include "envelope.h"
+
+/**
+ *
+ * @param buf Output buffer, ENVELOPE_PREFIX_SIZE bytes
+ * @param mode Signature mode
+ * @param chunk Bytes in a leaf chunk of the Merkle tree, 0 when the mode is not ENVELOPE_SIG_MERKLE
+ * @param arity Children of a node of the Merkle tree, 0 when the mode is not ENVELOPE_SIG_MERKLE
+ * @param m_size Size of the plain text
+ *
+ * @brief Writes what comes before the plain text in an envelope, the header and the length of the plain text.
+ */
+void put_envelope_prefix(unsigned char* buf,int mode,size_t chunk,size_t arity,size_t m_size){
+	memcpy(buf,ENVELOPE_MAGIC,4);
+	buf[4] = ENVELOPE_VERSION;
+	buf[5] = (unsigned char)mode;
+	buf[6] = 0;
+	buf[7] = 0;
+	put_uint_be(buf+8,chunk,8);
+	put_uint_be(buf+16,arity,8);
+	put_uint_be(buf+ENVELOPE_HEADER_SIZE,m_size,ENVELOPE_LENGTH_SIZE);
+}
+/**
+ *
+ * @param key Public or private key, only the modulus is used
+ * @param fp Output, KEY_FINGERPRINT_SIZE bytes
+ *
+ * @brief The fingerprint of a key is the SHA256 digest of its modulus as a big endian number.
+ *
+ * The public and the private key of a pair have the same fingerprint.
+ */
+void key_fingerprint(rsa_key* key,unsigned char* fp){
+	size_t width = (mpz_sizeinbase(key->n,BINARY) + 7) / 8;
+	unsigned char* n = (unsigned char*)malloc(width*sizeof(unsigned char));
+	sha256_context ctx;
+
+	export_fixed(n,width,key->n);
+	sha256_starts(&ctx);
+	sha256_update_buffer(&ctx,(const char*)n,width);
+	sha256_finish(&ctx,fp);
+	free(n);
+}
+/**
+ *
+ * @param sha256sum 32 byte digest
+ * @param rop Output, the digest with the marker bit above it
+ *
+ * @brief The number that is signed for a digest, the same with a packed block of the digest.
+ */
+static void digest_block(const unsigned char* sha256sum,mpz_t rop){
+	mpz_import(rop,32,1,1,1,0,sha256sum);
+	mpz_setbit(rop,8*32);
+}
+/**
+ *
+ * @param sha256sum 32 byte digest
+ * @param pr_key Private key of the sender
+ * @param sig Output, as many bytes as the modulus
+ *
+ * @brief Signs the digest with a single RSA operation, the signature is the raw block.
+ */
+void sign_digest(const unsigned char* sha256sum,rsa_key* pr_key,unsigned char* sig){
+	size_t width = (mpz_sizeinbase(pr_key->n,BINARY) + 7) / 8;
+	mpz_t m,s;
+
+	if(packed_block_size(pr_key) < 32){
+		fprintf(stderr,"The key is too small to sign a digest!\nExiting...\n");
+		exit(0);
+	}
+	mpz_init(m);
+	mpz_init(s);
+	digest_block(sha256sum,m);
+	rsa_key_exp(s,m,pr_key);
+	export_fixed(sig,width,s);
+	mpz_clear(m);
+	mpz_clear(s);
+}
+/**
+ *
+ * @param sha256sum 32 byte digest computed by the receiver
+ * @param sig Raw signature
+ * @param pu_key Public key of the sender
+ * @return true(1) if the signature is the signature of the digest, false(0) otherwise
+ *
+ * @brief Checks a signature created with sign_digest.
+ */
+int verify_digest(const unsigned char* sha256sum,byte_view sig,rsa_key* pu_key){
+	size_t width = (mpz_sizeinbase(pu_key->n,BINARY) + 7) / 8;
+	mpz_t s,m,expected;
+	int valid;
+
+	if(sig.size != width)
+		return 0;
+	mpz_init(s);
+	mpz_init(m);
+	mpz_init(expected);
+	mpz_import(s,sig.size,1,1,1,0,sig.data);
+	valid = mpz_cmp(s,pu_key->n) < 0;
+	if(valid){
+		rsa_key_exp(m,s,pu_key);
+		digest_block(sha256sum,expected);
+		valid = mpz_cmp(m,expected) == 0;
+	}
+	mpz_clear(s);
+	mpz_clear(m);
+	mpz_clear(expected);
+	return valid;
+}
+/**
+ *
+ * @param sha256sum 32 byte digest of the plain text, or the root of its Merkle tree
+ * @param pr_key Private key of the sender
+ * @param size Size of the returned data
+ * @return What comes after the plain text in an envelope, the signature and the fingerprint fields
+ *
+ * @brief Creates the fields after the plain text, it can be given to the fused functions as their suffix_func.
+ */
+char* create_envelope_suffix(const unsigned char* sha256sum,rsa_key* pr_key,size_t* size){
+	size_t width = (mpz_sizeinbase(pr_key->n,BINARY) + 7) / 8;
+	unsigned char* suffix;
+
+	*size = ENVELOPE_LENGTH_SIZE + width + ENVELOPE_LENGTH_SIZE + KEY_FINGERPRINT_SIZE;
+	suffix = (unsigned char*)malloc(*size*sizeof(unsigned char));
+	put_uint_be(suffix,width,ENVELOPE_LENGTH_SIZE);
+	sign_digest(sha256sum,pr_key,suffix+ENVELOPE_LENGTH_SIZE);
+	put_uint_be(suffix+ENVELOPE_LENGTH_SIZE+width,KEY_FINGERPRINT_SIZE,ENVELOPE_LENGTH_SIZE);
+	key_fingerprint(pr_key,suffix+2*ENVELOPE_LENGTH_SIZE+width);
+
+	return (char*)suffix;
+}
+/**
+ *
+ * @param buf Envelope
+ * @param size Size of the envelope
+ * @param pos Position of the field's length, it is moved after the field
+ * @param field Output, view of the field
+ * @return true(1) if the field is in the buffer, false(0) otherwise
+ *
+ * @brief Reads a length prefixed field.
+ */
+int read_envelope_field(const char* buf,size_t size,size_t* pos,byte_view* field){
+	unsigned long long len;
+
+	if(size - *pos < ENVELOPE_LENGTH_SIZE)
+		return 0;
+	len = get_uint_be((const unsigned char*)buf+*pos,ENVELOPE_LENGTH_SIZE);
+	*pos += ENVELOPE_LENGTH_SIZE;
+	if(len > size - *pos)
+		return 0;
+	field->data = buf + *pos;
+	field->size = (size_t)len;
+	*pos += field->size;
+	return 1;
+}
+/**
+ *
+ * @param buf Decrypted message
+ * @param size Size of the decrypted message
+ * @param env Output, its fields point into buf
+ * @return true(1) if the message is a valid envelope, false(0) otherwise
+ *
+ * @brief Parses an envelope without copying, the views are valid as long as buf is.
+ */
+int parse_envelope(const char* buf,size_t size,envelope* env){
+	const unsigned char* header = (const unsigned char*)buf;
+	size_t pos = ENVELOPE_HEADER_SIZE;
+
+	if(size < ENVELOPE_PREFIX_SIZE || memcmp(buf,ENVELOPE_MAGIC,4) != 0 || header[4] != ENVELOPE_VERSION)
+		return 0;
+	env->mode = header[5];
+	env->chunk = (size_t)get_uint_be(header+8,8);
+	env->arity = (size_t)get_uint_be(header+16,8);
+	if(env->mode != ENVELOPE_SIG_HASH && env->mode != ENVELOPE_SIG_MERKLE)
+		return 0;
+	if(env->mode == ENVELOPE_SIG_MERKLE && !is_merkle_shape_valid(env->chunk,env->arity))
+		return 0;
+
+	return read_envelope_field(buf,size,&pos,&env->message)
+			&& read_envelope_field(buf,size,&pos,&env->signature)
+			&& read_envelope_field(buf,size,&pos,&env->fingerprint)
+			&& pos == size;
+}
+/**
+ *
+ * @param env Parsed envelope
+ * @param pu_key Public key of the sender
+ * @return true(1) if the envelope is signed by the owner of the key, false(0) otherwise
+ *
+ * @brief Authenticates the plain text of an envelope.
+ *
+ * The fingerprint is checked first, so a message from another sender fails without an RSA operation. Then the digest
+ * of the plain text, or the root of its Merkle tree built with the receiver's threads, is checked against the signature.
+ */
+int authenticate_envelope(envelope* env,rsa_key* pu_key){
+	unsigned char fp[KEY_FINGERPRINT_SIZE];
+	unsigned char sha256sum[32];
+	sha256_context ctx;
+
+	key_fingerprint(pu_key,fp);
+	if(env->fingerprint.size != KEY_FINGERPRINT_SIZE || memcmp(env->fingerprint.data,fp,KEY_FINGERPRINT_SIZE) != 0)
+		return 0;
+
+	if(env->mode == ENVELOPE_SIG_MERKLE){
+		create_merkle_root(env->message.data,env->message.size,env->chunk,env->arity,sha256sum);
+	}
+	else{
+		sha256_starts(&ctx);
+		sha256_update_buffer(&ctx,env->message.data,env->message.size);
+		sha256_finish(&ctx,sha256sum);
+	}
+	return verify_digest(sha256sum,env->signature,pu_key);
+}
@@ -0,0 +1,94 @@
+/**
+ * @file
+ * @brief Binary envelope of a message, its signature and the sender's key fingerprint.
+ *
+ * The old messages are the plain text, a "\n#######\n" separator and the signature as decimal text, so the receiver
+ * has to search the separator and copy both parts. The envelope is a versioned header followed by fields which
+ * start with their lengths: the plain text, the signature and the fingerprint of the sender's key. The signature
+ * is the raw RSA block of the digest, as many bytes as the modulus, which is smaller than its decimal text. The
+ * receiver reads the lengths and gets views into the decrypted buffer, nothing is searched or copied.
+ *
+ * header: magic(4) version(1) signature mode(1) reserved(2) Merkle chunk size(8) Merkle arity(8)
+ * fields: length(8) plain text, length(8) signature, length(8) fingerprint
+ *
+ * All numbers are big endian. The header and the length of the plain text come before the plain text, they are known
+ * before it is read, so the plain text is still hashed and encrypted in a single pass. It is implemented in envelope.c.
+ */
+
+#ifndef ENVELOPE_H_
+#define ENVELOPE_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gmp.h>
+#include "sha256.h"
+#include "rsa_opts.h"
+#include "general_opts.h"
+#include "merkle_opts.h"
+
+/**
+ * Magic bytes at the start of an envelope.
+ */
+#define ENVELOPE_MAGIC "RMXE"
+/**
+ * Version of the envelope format.
+ */
+#define ENVELOPE_VERSION 1
+/**
+ * Signature mode of an envelope whose signature is made from the SHA256 digest of the plain text.
+ */
+#define ENVELOPE_SIG_HASH 1
+/**
+ * Signature mode of an envelope whose signature is made from the root of the Merkle tree of the plain text.
+ */
+#define ENVELOPE_SIG_MERKLE 2
+/**
+ * Size of the header of an envelope.
+ */
+#define ENVELOPE_HEADER_SIZE 24
+/**
+ * Size of the length in front of each field.
+ */
+#define ENVELOPE_LENGTH_SIZE 8
+/**
+ * Bytes before the plain text, the header and the length of the plain text.
+ */
+#define ENVELOPE_PREFIX_SIZE (ENVELOPE_HEADER_SIZE + ENVELOPE_LENGTH_SIZE)
+/**
+ * Size of a key fingerprint, the SHA256 digest of the modulus.
+ */
+#define KEY_FINGERPRINT_SIZE 32
+
+/**
+ * @struct BYTE_VIEW
+ * @brief BYTE_VIEW is a part of a buffer, it is not terminated and not copied.
+ */
+typedef struct BYTE_VIEW {
+	const char* data; // first byte of the part
+	size_t size; // size of the part
+}byte_view;
+
+/**
+ * @struct ENVELOPE
+ * @brief ENVELOPE is a parsed envelope, its fields are views into the decrypted buffer.
+ */
+typedef struct ENVELOPE {
+	int mode; // ENVELOPE_SIG_HASH or ENVELOPE_SIG_MERKLE
+	size_t chunk; // bytes in a leaf chunk of the Merkle tree
+	size_t arity; // children of a node of the Merkle tree
+	byte_view message; // plain text
+	byte_view signature; // raw signature, as many bytes as the sender's modulus
+	byte_view fingerprint; // fingerprint of the sender's key
+}envelope;
+
+void put_envelope_prefix(unsigned char* buf,int mode,size_t chunk,size_t arity,size_t m_size);
+void key_fingerprint(rsa_key* key,unsigned char* fp);
+void sign_digest(const unsigned char* sha256sum,rsa_key* pr_key,unsigned char* sig);
+int verify_digest(const unsigned char* sha256sum,byte_view sig,rsa_key* pu_key);
+char* create_envelope_suffix(const unsigned char* sha256sum,rsa_key* pr_key,size_t* size);
+int read_envelope_field(const char* buf,size_t size,size_t* pos,byte_view* field);
+int parse_envelope(const char* buf,size_t size,envelope* env);
+int authenticate_envelope(envelope* env,rsa_key* pu_key);
+
+#endif /* ENVELOPE_H_ */
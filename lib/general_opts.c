@@ -0,0 +1,1461 @@
+/**
+ * @file
+ * @brief Encryption, decryption, hashing, signatures and file operations.
+ */
+
+#include "general_opts.h"
+
+/**
+ * Hexadecimal digits used to print the hashes.
+ */
+static const char hex_digits[16] = {'0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f'};
+
+/**
+ *
+ * @param ctx SHA256 context
+ * @param data Data
+ * @param size Size of the data
+ *
+ * @brief Adds the data to the hash in bulk.
+ *
+ * sha256_update takes a 32 bit length, so very large data is given to it in pieces of 1 GB.
+ */
+void sha256_update_buffer(sha256_context* ctx,const char* data,size_t size){
+	size_t n;
+
+	while(size > 0){
+		n = size < ((size_t)1 << 30) ? size : ((size_t)1 << 30);
+		sha256_update(ctx,(unsigned char*)data,(unsigned int)n);
+		data += n;
+		size -= n;
+	}
+}
+/**
+ *
+ * @param sha256sum 32 byte SHA256 digest
+ * @return Hexadecimal string of the digest
+ *
+ * @brief Writes the digest as a 64 character lowercase hexadecimal string.
+ */
+char* digest_to_hex(const unsigned char* sha256sum){
+	char* output = (char*)malloc((64+1)*sizeof(char));
+	int j;
+
+	for(j = 0; j < 32; j++){
+		output[2*j] = hex_digits[sha256sum[j] >> 4];
+		output[2*j+1] = hex_digits[sha256sum[j] & 0x0f];
+	}
+	output[64] = '\0';
+	return output;
+}
+/**
+ *
+ * @param str Input string
+ * @param size Size of the string
+ * @return Hashed value.
+ *
+ * @brief Hashes the given string value
+ *
+ * Creates the hash of the input string using SHA256 (Secure Hash Algorithm 256 Bits)
+ * secure hash algorithm. The SHA256's output is a 256bit hexadecimal number. The source
+ * code of the used SHA256 can be found in sha256.h file.
+ */
+char* create_hash_of_string(char* str,size_t size){
+	sha256_context ctx;
+	unsigned char sha256sum[32];
+
+	sha256_starts(&ctx);
+	sha256_update_buffer(&ctx,str,size);
+	sha256_finish(&ctx, sha256sum);
+
+	return digest_to_hex(sha256sum);
+}
+/**
+ *
+ * @param filename
+ * @return Hashed value.
+ *
+ * @brief Hashes the given file
+ *
+ * Creates the hash of the given file using SHA256 (Secure Hash Algorithm 256 Bits)
+ * secure hash algorithm. The SHA256's output is a 256bit hexadecimal number. The source
+ * code of the used SHA256 can be found in sha256.h file.
+ */
+char* create_hash_of_file(char* filename){
+	sha256_context ctx;
+	unsigned char sha256sum[32];
+	size_t i;
+	unsigned char buf[65536];
+	FILE* f;
+
+	if(!(f = fopen(filename, "rb")))
+	{
+		fprintf(stderr,"fopen failed %s\n",filename);
+		exit(0);
+	}
+
+    sha256_starts( &ctx );
+
+    // read file buff size
+    while((i = fread(buf, 1, sizeof(buf), f)) > 0 )// while there are things to read
+    {
+        sha256_update(&ctx, buf, i);//add to hash
+    }
+
+    sha256_finish(&ctx, sha256sum);
+
+	fclose(f);
+	return digest_to_hex(sha256sum);
+}
+/**
+ *
+ * @param i Index of the block
+ * @param arg The job
+ *
+ * @brief Encrypts the i'th 4 character block of the plain text.
+ */
+void pub_enc_block(size_t i,void* arg){
+	block_job* job = (block_job*)arg;
+	mpz_ptr enc_base = get_thread_arena()->num[ARENA_NUM_BLOCK];
+
+	/// the block is compressed by pub_enc
+	mpz_set_ui(enc_base,job->blocks[i]);
+	rsa_key_exp(job->out[i],enc_base,job->key); /// exponentiation
+}
+/**
+ *
+ * @param m Plain Text
+ * @param key Public key
+ * @return The encrypted text
+ *
+ * @brief Encrypts the given plain text with the given public key
+ *
+ * This function basically does the RSA encryption. The method used to represent characters
+ * as numbers is compression. Every 4 character block is put into an integer and this integer
+ * value is encrypted. Encryption is done via exponentiation. The blocks are encrypted by the block engine.
+ *
+ * C = M^e mod n
+ */
+char* pub_enc(char* m,rsa_key* key){
+	int m_size = strlen(m); /// size of the plain text
+
+	/// cycle_number is the number which determines how many compressions will be made and as a result the encrypted portions number.
+	int cycle_number = m_size % 4 > 0 ? (m_size/4) + 1: (m_size/4);
+	/// key_length determines the max length of the encrypted value
+	size_t key_length = mpz_sizeinbase(key->n,DECIMAL);
+
+	block_job job;
+	arena* scratch = get_thread_arena();
+	arena_mark mark;
+	int i;
+
+	/// there will be cycle_number encrypted value as a result,which can be at most at the length of n, since they are taken mod of n so we allocate memory according to that values. In addition there will be separators '\n' at the end of each encrypted value.
+	out_buf* buf = create_out_buf((key_length*cycle_number)+cycle_number);
+
+	job.key = key;
+	job.in = m;
+	/// compress every 4 chars of the plain text to an int at once, in the scratch memory of the message
+	mark = arena_save(scratch);
+	job.blocks = (uint32_t*)arena_alloc(scratch,(cycle_number+1)*sizeof(uint32_t));
+	pack_char_blocks(m,m_size,job.blocks);
+	job.out = (mpz_t*)malloc(cycle_number*sizeof(mpz_t));
+	for (i = 0; i < cycle_number; ++i) {
+		mpz_init2(job.out[i],(mpz_size(key->n)+1)*GMP_NUMB_BITS); /// the blocks do not reallocate their results
+	}
+	get_rsa_key_ctx(key); /// build the context before the workers share it
+
+	run_block_engine(cycle_number,pub_enc_block,&job);
+	arena_restore(scratch,mark);
+
+	for (i = 0; i < cycle_number; ++i) {
+		/// add the exponentiated value to the end of the string
+		out_buf_append_mpz(buf,job.out[i],DECIMAL,'\n');
+		mpz_clear(job.out[i]);
+	}
+
+	free(job.out);
+	return out_buf_release(buf,NULL);
+}
+/**
+ *
+ * @param key The key
+ * @return Number of plain text bytes in a block
+ *
+ * @brief Computes the block size of the packed block mode for the key.
+ *
+ * A block is filled up to the byte length of n minus BLOCK_PAD_MARGIN bytes.
+ */
+size_t packed_block_size(rsa_key* key){
+	size_t n_bytes = (mpz_sizeinbase(key->n,BINARY) + 7) / 8;
+
+	if(n_bytes <= BLOCK_PAD_MARGIN){
+		fprintf(stderr,"The key is too small for the packed block mode!\nExiting...\n");
+		exit(0);
+	}
+	return n_bytes - BLOCK_PAD_MARGIN;
+}
+/**
+ *
+ * @param rop Encrypted block
+ * @param job The job
+ * @param i Index of the block
+ *
+ * @brief Encrypts the i'th block of the plain text in the packed block mode.
+ *
+ * The block is read as a big endian number and the marker bit is set right above its top byte.
+ */
+void encrypt_packed_block(mpz_t rop,block_job* job,size_t i){
+	size_t start = i*job->block_size;
+	size_t len = job->in_size - start < job->block_size ? job->in_size - start : job->block_size;
+	mpz_ptr enc_base = get_thread_arena()->num[ARENA_NUM_BLOCK];
+
+	mpz_import(enc_base,len,1,1,1,0,job->in+start); /// read the block as a big endian number
+	mpz_setbit(enc_base,8*len); /// put the marker byte in front
+	rsa_key_exp(rop,enc_base,job->key); /// exponentiation
+}
+/**
+ *
+ * @param i Index of the block
+ * @param arg The job
+ *
+ * @brief Encrypts the i'th block of the plain text in the packed block mode into the job's output numbers.
+ */
+void pub_enc_packed_block(size_t i,void* arg){
+	block_job* job = (block_job*)arg;
+	encrypt_packed_block(job->out[i],job,i);
+}
+/**
+ *
+ * @param m Plain Text
+ * @param m_size Size of the plain text
+ * @param key Public key
+ * @return The encrypted text
+ *
+ * @brief Encrypts the given plain text with the given public key in the packed block mode
+ *
+ * Instead of 4 characters, each block is filled with as many characters as the key allows (see packed_block_size).
+ * The block is the marker byte followed by the characters, read as a big endian number. The encrypted text starts
+ * with the PACKED_TAG line so pri_dec knows the mode, the rest is the same with pub_enc.
+ *
+ * C = M^e mod n
+ */
+char* pub_enc_packed(char* m,size_t m_size,rsa_key* key){
+	size_t block_size = packed_block_size(key);
+	size_t cycle_number = (m_size + block_size - 1) / block_size; /// number of blocks
+	size_t key_length = mpz_sizeinbase(key->n,DECIMAL);
+	size_t i;
+	block_job job;
+
+	/// each block takes at most key_length digits and the separator, plus the tag
+	out_buf* buf = create_out_buf((key_length+1)*cycle_number + strlen(PACKED_TAG));
+	out_buf_append_str(buf,PACKED_TAG);
+
+	job.key = key;
+	job.in = m;
+	job.in_size = m_size;
+	job.block_size = block_size;
+	job.out = (mpz_t*)malloc(cycle_number*sizeof(mpz_t));
+	for (i = 0; i < cycle_number; ++i) {
+		mpz_init2(job.out[i],(mpz_size(key->n)+1)*GMP_NUMB_BITS); /// the blocks do not reallocate their results
+	}
+	get_rsa_key_ctx(key); /// build the context before the workers share it
+
+	run_block_engine(cycle_number,pub_enc_packed_block,&job);
+
+	for (i = 0; i < cycle_number; ++i) {
+		out_buf_append_mpz(buf,job.out[i],DECIMAL,'\n');
+		mpz_clear(job.out[i]);
+	}
+
+	free(job.out);
+	return out_buf_release(buf,NULL);
+}
+/**
+ *
+ * @param c_val Ciphered number
+ * @param job The job
+ * @param i Index of the block
+ *
+ * @brief Decrypts the i'th ciphered number in the packed block mode.
+ *
+ * The marker bit is cleared and the rest of the block is written to the block's place in the decrypted text.
+ */
+void decrypt_packed_block(mpz_t c_val,block_job* job,size_t i){
+	mpz_ptr result = get_thread_arena()->num[ARENA_NUM_RESULT];
+	size_t bits,len;
+
+	rsa_key_exp(result,c_val,job->key); /// decrypt the ciphered number
+
+	/// the top bit of the block is the marker bit, the block is at most block_size bytes without it
+	bits = mpz_sizeinbase(result,BINARY);
+	len = (bits - 1) / 8;
+	if(mpz_sgn(result) == 0 || (bits - 1) % 8 != 0 || len > job->block_size){
+		fprintf(stderr,"Deciphered block is not valid, wrong key?\nExiting...\n");
+		exit(0);
+	}
+	mpz_clrbit(result,8*len);
+	export_fixed((unsigned char*)job->ret+(i*job->block_size),len,result);
+	job->lens[i] = len;
+}
+/**
+ *
+ * @param i Index of the block
+ * @param arg The job
+ *
+ * @brief Reads the i'th ciphered number of the text and decrypts it in the packed block mode.
+ */
+void pri_dec_packed_block(size_t i,void* arg){
+	block_job* job = (block_job*)arg;
+	mpz_ptr c_val = get_thread_arena()->num[ARENA_NUM_BLOCK];
+
+	gmp_sscanf(job->in+job->starts[i],"%Zd",c_val);/// read the ciphered number into c_val
+	decrypt_packed_block(c_val,job,i);
+}
+/**
+ *
+ * @param job The job
+ * @param count Number of blocks
+ * @return Length of the decrypted text
+ *
+ * @brief Moves the decrypted blocks next to each other and terminates the decrypted text.
+ *
+ * Each block was written to its own place of block_size bytes, only the last block can be shorter.
+ */
+size_t join_packed_blocks(block_job* job,size_t count){
+	size_t ret_index = 0,i;
+
+	for (i = 0; i < count; ++i) {
+		if(ret_index != i*job->block_size){
+			memmove(job->ret+ret_index,job->ret+(i*job->block_size),job->lens[i]);
+		}
+		ret_index += job->lens[i];
+	}
+	job->ret[ret_index] = '\0';
+	return ret_index;
+}
+/**
+ *
+ * @param c Ciphered Text in the packed block mode
+ * @param key Private Key
+ * @return The decrypted text
+ *
+ * @brief Decrypts the given ciphered text, which was encrypted with pub_enc_packed
+ *
+ * Each decrypted block is written out as bytes; the marker byte is dropped and the rest of the block is the plain text.
+ * The blocks are decrypted by the block engine.
+ *
+ * M = C^d mod n
+ */
+char* pri_dec_packed(char* c,rsa_key* key){
+	size_t block_size = packed_block_size(key);
+	size_t ciphered_cnt = 0,i;
+	block_job job;
+	char *p;
+
+	c += strlen(PACKED_TAG);
+
+	/// find how many ciphered blocks are there in the ciphered text
+	for (p = c; *p != '\0'; ++p) {
+		if(*p == '\n'){
+			ciphered_cnt++;
+		}
+	}
+
+	job.key = key;
+	job.in = c;
+	job.block_size = block_size;
+	job.starts = (size_t*)malloc((ciphered_cnt+1)*sizeof(size_t));
+	job.lens = (size_t*)malloc((ciphered_cnt+1)*sizeof(size_t));
+	job.ret = (char*)malloc((ciphered_cnt*block_size + 1)*sizeof(char));
+
+	/// each number in the ciphered text(separated via newline) starts after the previous newline
+	job.starts[0] = 0;
+	for (p = c, i = 1; *p != '\0'; ++p) {
+		if(*p == '\n'){
+			job.starts[i++] = (p - c) + 1;
+		}
+	}
+	get_rsa_key_ctx(key); /// build the context before the workers share it
+
+	run_block_engine(ciphered_cnt,pri_dec_packed_block,&job);
+
+	join_packed_blocks(&job,ciphered_cnt);
+
+	free(job.starts);
+	free(job.lens);
+	return job.ret;
+}
+/**
+ *
+ * @param m Plain Text
+ * @param m_size Size of the plain text
+ * @param key Private key
+ * @return The encrypted text
+ *
+ * @brief Encrypts the given plain text with the given private key in the packed block mode
+ *
+ * C = M^e mod n
+ */
+char* pri_enc_packed(char* m,size_t m_size,rsa_key* key){
+	return pub_enc_packed(m,m_size,key);
+}
+/**
+ *
+ * @param b Output buffer
+ * @param x Number to write
+ * @param bytes Number of bytes
+ *
+ * @brief Writes the number as a big endian number of the given number of bytes.
+ */
+void put_uint_be(unsigned char* b,unsigned long long x,int bytes){
+	int i;
+	for(i = bytes - 1; i >= 0; i--){
+		b[i] = (unsigned char)(x & 0xFF);
+		x >>= 8;
+	}
+}
+/**
+ *
+ * @param b Input buffer
+ * @param bytes Number of bytes
+ * @return The number
+ *
+ * @brief Reads a big endian number of the given number of bytes.
+ */
+unsigned long long get_uint_be(const unsigned char* b,int bytes){
+	unsigned long long x = 0;
+	int i;
+	for(i = 0; i < bytes; i++)
+		x = (x << 8) | b[i];
+	return x;
+}
+/**
+ *
+ * @param c Ciphered data
+ * @param c_size Size of the ciphered data
+ * @return true(1) if the data is a binary ciphered file, false(0) otherwise
+ *
+ * @brief Checks the magic bytes of the binary ciphered file format.
+ */
+int is_cipher_container(char* c,size_t c_size){
+	return c_size >= CONTAINER_HEADER_SIZE && memcmp(c,CONTAINER_MAGIC,4) == 0;
+}
+/**
+ *
+ * @param buf Output buffer, CONTAINER_HEADER_SIZE bytes
+ * @param mode Mode of the blocks
+ * @param width Bytes of an encrypted block
+ * @param count Number of blocks
+ *
+ * @brief Writes the header of the binary ciphered file format.
+ */
+void put_container_header(unsigned char* buf,int mode,size_t width,size_t count){
+	memcpy(buf,CONTAINER_MAGIC,4);
+	buf[4] = CONTAINER_VERSION;
+	buf[5] = (unsigned char)mode;
+	buf[6] = 0;
+	buf[7] = 0;
+	put_uint_be(buf+8,width,4);
+	put_uint_be(buf+12,count,8);
+}
+/**
+ *
+ * @param i Index of the block
+ * @param arg The job
+ *
+ * @brief Encrypts the i'th block in the packed block mode and writes it to its fixed place in the binary output.
+ */
+void pub_enc_bin_block(size_t i,void* arg){
+	block_job* job = (block_job*)arg;
+	mpz_ptr enc_res = get_thread_arena()->num[ARENA_NUM_RESULT];
+
+	encrypt_packed_block(enc_res,job,i);
+	export_fixed(job->bin+(i*job->width),job->width,enc_res);
+}
+/**
+ *
+ * @param m Plain Text
+ * @param m_size Size of the plain text
+ * @param key Public key
+ * @param out_size Size of the encrypted data
+ * @return The encrypted data
+ *
+ * @brief Encrypts the given plain text in the packed block mode into the binary ciphered file format
+ *
+ * The blocks are the same with pub_enc_packed, but each encrypted block is written as a big endian number of the byte
+ * length of n, after a header with the block width and the block count. There is no base conversion and the
+ * place of each block is known.
+ *
+ * C = M^e mod n
+ */
+char* pub_enc_bin(char* m,size_t m_size,rsa_key* key,size_t* out_size){
+	size_t block_size = packed_block_size(key);
+	size_t cycle_number = (m_size + block_size - 1) / block_size; /// number of blocks
+	size_t width = (mpz_sizeinbase(key->n,BINARY) + 7) / 8; /// bytes of an encrypted block
+	unsigned char* buf;
+	block_job job;
+
+	*out_size = CONTAINER_HEADER_SIZE + cycle_number*width;
+	buf = (unsigned char*)malloc(*out_size*sizeof(unsigned char));
+
+	put_container_header(buf,CONTAINER_MODE_PACKED,width,cycle_number);
+
+	job.key = key;
+	job.in = m;
+	job.in_size = m_size;
+	job.block_size = block_size;
+	job.bin = buf + CONTAINER_HEADER_SIZE;
+	job.width = width;
+	get_rsa_key_ctx(key); /// build the context before the workers share it
+
+	run_block_engine(cycle_number,pub_enc_bin_block,&job);
+
+	return (char*)buf;
+}
+/**
+ *
+ * @param i Index of the block
+ * @param arg The job
+ *
+ * @brief Reads the i'th block of the binary ciphered data and decrypts it in the packed block mode.
+ */
+void pri_dec_bin_block(size_t i,void* arg){
+	block_job* job = (block_job*)arg;
+	mpz_ptr c_val = get_thread_arena()->num[ARENA_NUM_BLOCK];
+
+	mpz_import(c_val,job->width,1,1,1,0,job->bin+(i*job->width));
+	decrypt_packed_block(c_val,job,i);
+}
+/**
+ *
+ * @param c Ciphered data in the binary ciphered file format
+ * @param c_size Size of the ciphered data
+ * @param key Private Key
+ * @param out_size Size of the decrypted text, can be NULL
+ * @return The decrypted text
+ *
+ * @brief Decrypts the given binary ciphered data, which was encrypted with pub_enc_bin
+ *
+ * The header is checked against the key and the size of the data, then the offset of each block is computed directly.
+ *
+ * M = C^d mod n
+ */
+char* pri_dec_bin(char* c,size_t c_size,rsa_key* key,size_t* out_size){
+	unsigned char* buf = (unsigned char*)c;
+	size_t width,count,len;
+	block_job job;
+
+	if(!is_cipher_container(c,c_size) || buf[4] != CONTAINER_VERSION || buf[5] != CONTAINER_MODE_PACKED){
+		fprintf(stderr,"Unknown ciphered file format!\nExiting...\n");
+		exit(0);
+	}
+
+	width = get_uint_be(buf+8,4);
+	count = get_uint_be(buf+12,8);
+	if(width != (mpz_sizeinbase(key->n,BINARY) + 7) / 8 || (c_size - CONTAINER_HEADER_SIZE) / width < count){
+		fprintf(stderr,"Ciphered file does not match the key!\nExiting...\n");
+		exit(0);
+	}
+
+	job.key = key;
+	job.block_size = packed_block_size(key);
+	job.bin = buf + CONTAINER_HEADER_SIZE;
+	job.width = width;
+	job.lens = (size_t*)malloc((count+1)*sizeof(size_t));
+	job.ret = (char*)malloc((count*job.block_size + 1)*sizeof(char));
+	get_rsa_key_ctx(key); /// build the context before the workers share it
+
+	run_block_engine(count,pri_dec_bin_block,&job);
+
+	len = join_packed_blocks(&job,count);
+	if(out_size != NULL)
+		*out_size = len;
+
+	free(job.lens);
+	return job.ret;
+}
+/**
+ *
+ * @param buf Start of the binary ciphered data, the header and the session key block are written here
+ * @param key Public key
+ * @param cipher The cipher, set up with the session key
+ *
+ * @brief Starts a message in the hybrid mode.
+ *
+ * A random session key and nonce are generated and encrypted with a single RSA operation in the packed block mode.
+ * The header has a block count of 1 and is followed by the encrypted session key block.
+ */
+void start_hybrid(unsigned char* buf,rsa_key* key,chacha20_ctx* cipher){
+	size_t width = (mpz_sizeinbase(key->n,BINARY) + 7) / 8; /// bytes of an encrypted block
+	unsigned char session[HYBRID_SESSION_SIZE];
+	block_job job;
+	mpz_t enc_res;
+
+	job.block_size = packed_block_size(key);
+	if(job.block_size < HYBRID_SESSION_SIZE){
+		fprintf(stderr,"The key is too small for the hybrid mode!\nExiting...\n");
+		exit(0);
+	}
+
+	put_container_header(buf,CONTAINER_MODE_HYBRID,width,1);
+
+	/// encrypt the session key with RSA
+	rand_bytes(get_thread_rand_source(),session,HYBRID_SESSION_SIZE);
+	job.key = key;
+	job.in = (char*)session;
+	job.in_size = HYBRID_SESSION_SIZE;
+	mpz_init(enc_res);
+	encrypt_packed_block(enc_res,&job,0);
+	export_fixed(buf+CONTAINER_HEADER_SIZE,width,enc_res);
+	mpz_clear(enc_res);
+
+	chacha20_init(cipher,session,session+CHACHA20_KEY_SIZE,0);
+	memset(session,0,HYBRID_SESSION_SIZE);
+}
+/**
+ *
+ * @param m Plain Text
+ * @param m_size Size of the plain text
+ * @param key Public key
+ * @param out_size Size of the encrypted data
+ * @return The encrypted data
+ *
+ * @brief Encrypts the given plain text in the hybrid mode into the binary ciphered file format
+ *
+ * Only the session key is encrypted with RSA (see start_hybrid). The plain text itself is encrypted with the
+ * ChaCha20 stream cipher under the session key, which is much faster than RSA. The encrypted session key block
+ * is followed by the encrypted plain text.
+ */
+char* pub_enc_hybrid(char* m,size_t m_size,rsa_key* key,size_t* out_size){
+	size_t width = (mpz_sizeinbase(key->n,BINARY) + 7) / 8; /// bytes of an encrypted block
+	unsigned char* buf;
+	chacha20_ctx cipher;
+
+	*out_size = CONTAINER_HEADER_SIZE + width + m_size;
+	buf = (unsigned char*)malloc(*out_size*sizeof(unsigned char));
+	start_hybrid(buf,key,&cipher);
+
+	/// encrypt the plain text with the session key
+	chacha20_xor(&cipher,(unsigned char*)m,buf+CONTAINER_HEADER_SIZE+width,m_size);
+
+	memset(&cipher,0,sizeof(cipher));
+	return (char*)buf;
+}
+/**
+ *
+ * @param c Ciphered data in the hybrid mode
+ * @param c_size Size of the ciphered data
+ * @param key Private Key
+ * @param out_size Size of the decrypted text, can be NULL
+ * @return The decrypted text
+ *
+ * @brief Decrypts the given binary ciphered data, which was encrypted with pub_enc_hybrid
+ *
+ * The session key is decrypted with RSA, then the rest of the data is decrypted with ChaCha20.
+ */
+char* pri_dec_hybrid(char* c,size_t c_size,rsa_key* key,size_t* out_size){
+	unsigned char* buf = (unsigned char*)c;
+	size_t width,body_size;
+	chacha20_ctx cipher;
+	block_job job;
+	size_t len;
+	mpz_t c_val;
+
+	width = get_uint_be(buf+8,4);
+	if(width != (mpz_sizeinbase(key->n,BINARY) + 7) / 8 || get_uint_be(buf+12,8) != 1 || c_size < CONTAINER_HEADER_SIZE + width){
+		fprintf(stderr,"Ciphered file does not match the key!\nExiting...\n");
+		exit(0);
+	}
+	body_size = c_size - CONTAINER_HEADER_SIZE - width;
+
+	/// decrypt the session key with RSA
+	job.key = key;
+	job.block_size = packed_block_size(key);
+	job.ret = (char*)malloc((job.block_size+1)*sizeof(char));
+	job.lens = &len;
+	mpz_init(c_val);
+	mpz_import(c_val,width,1,1,1,0,buf+CONTAINER_HEADER_SIZE);
+	decrypt_packed_block(c_val,&job,0);
+	mpz_clear(c_val);
+	if(len != HYBRID_SESSION_SIZE){
+		fprintf(stderr,"Session key is not valid, wrong key?\nExiting...\n");
+		exit(0);
+	}
+
+	/// decrypt the body with the session key
+	chacha20_init(&cipher,(unsigned char*)job.ret,(unsigned char*)job.ret+CHACHA20_KEY_SIZE,0);
+	memset(job.ret,0,HYBRID_SESSION_SIZE);
+	free(job.ret);
+
+	job.ret = (char*)malloc((body_size+1)*sizeof(char));
+	chacha20_xor(&cipher,buf+CONTAINER_HEADER_SIZE+width,(unsigned char*)job.ret,body_size);
+	job.ret[body_size] = '\0';
+	memset(&cipher,0,sizeof(cipher));
+
+	if(out_size != NULL)
+		*out_size = body_size;
+	return job.ret;
+}
+/**
+ *
+ * @param c Ciphered data in the binary ciphered file format
+ * @param c_size Size of the ciphered data
+ * @param key Private Key
+ * @param out_size Size of the decrypted text, can be NULL
+ * @return The decrypted text
+ *
+ * @brief Decrypts binary ciphered data of any mode.
+ *
+ * The mode byte of the header tells if the data is in the packed block mode or in the hybrid mode.
+ */
+char* pri_dec_container(char* c,size_t c_size,rsa_key* key,size_t* out_size){
+	if(is_cipher_container(c,c_size) && c[4] == CONTAINER_VERSION && c[5] == CONTAINER_MODE_HYBRID)
+		return pri_dec_hybrid(c,c_size,key,out_size);
+	return pri_dec_bin(c,c_size,key,out_size);
+}
+/**
+ *
+ * @param i Index of the block
+ * @param arg The job
+ *
+ * @brief Decrypts the i'th ciphered number, its 4 characters are decompressed by pri_dec.
+ */
+void pri_dec_block(size_t i,void* arg){
+	block_job* job = (block_job*)arg;
+	arena* scratch = get_thread_arena();
+	mpz_ptr c_val = scratch->num[ARENA_NUM_BLOCK];
+	mpz_ptr result = scratch->num[ARENA_NUM_RESULT];
+
+	gmp_sscanf(job->in+job->starts[i],"%Zd",c_val);/// read the ciphered number into c_val
+	rsa_key_exp(result,c_val,job->key); /// decrypt the read number;
+	/// each block contains 4 characters that is compressed into an integer, pri_dec decompresses them all at once
+	job->blocks[i] = (uint32_t)mpz_get_ui(result);
+}
+/**
+ *
+ * @param c Ciphered Text
+ * @param key Private Key
+ * @return The decrypted text
+ *
+ * @brief Decrypts the given ciphered text(encrypted with public encryption) with the given private key
+ *
+ * This function basically does the RSA decryption. Decompression is done to reveal the 4 characters we
+ * compressed after decryption. Ciphered texts that start with the PACKED_TAG line are decrypted with pri_dec_packed.
+ * The blocks are decrypted by the block engine.
+ *
+ * M = C^d mod n
+ */
+char* pri_dec(char* c,rsa_key* key){
+	int i,c_size = strlen(c);
+	int ciphered_cnt = 0; /// will count the total number of decrypted texts
+	block_job job;
+	arena* scratch = get_thread_arena();
+	arena_mark mark;
+
+	if(c_size == 0){ /// if ciphered text is empty exit
+		fprintf(stderr,"No ciphered value to decipher!\nExiting...\n");
+		exit(0);
+	}
+
+	if(strncmp(c,PACKED_TAG,strlen(PACKED_TAG)) == 0){ /// packed block mode
+		return pri_dec_packed(c,key);
+	}
+
+	/// find how many integers/ciphered blocks are there in the ciphered file
+	for (i = 0; i < c_size; ++i) {
+		if(c[i] == '\n'){
+			ciphered_cnt++;
+		}
+	}
+
+	job.key = key;
+	job.in = c;
+	job.starts = (size_t*)malloc((ciphered_cnt+1)*sizeof(size_t));
+	/// allocate the return value, we know the total number of ciphered blocks of characters
+	job.ret = (char*)malloc(((ciphered_cnt*4)+3)*sizeof(char));
+
+	/// each number in the ciphered text(seperated via newline) starts after the previous newline
+	job.starts[0] = 0;
+	ciphered_cnt = 0;
+	for (i = 0; i < c_size; ++i) {
+		if(c[i] == '\n'){
+			job.starts[++ciphered_cnt] = i + 1;
+		}
+	}
+	get_rsa_key_ctx(key); /// build the context before the workers share it
+
+	mark = arena_save(scratch);
+	job.blocks = (uint32_t*)arena_alloc(scratch,(ciphered_cnt+1)*sizeof(uint32_t));
+	run_block_engine(ciphered_cnt,pri_dec_block,&job);
+
+	/// decompress the ints to 4 chars each, every block in its place in the return string
+	unpack_char_blocks(job.blocks,ciphered_cnt,job.ret);
+	job.ret[ciphered_cnt*4] = '\0';
+	arena_restore(scratch,mark);
+	free(job.starts);
+	return job.ret;
+}
+/**
+ *
+ * @param c Ciphered Text
+ * @param key Public Key
+ * @return The decrypted text
+ *
+ * @brief Decrypts the given ciphered text(encrypted with private encryption) with the given public key
+ *
+ * The function does the general decryption with public key. It resolves the encryption with private key.
+ *
+ * M = C^d mod n
+ */
+char* pub_dec(char* c,rsa_key* key){
+	return pri_dec(c,key);
+}
+/**
+ *
+ * @param m Plain Text
+ * @param key Private key
+ * @return The encrypted text
+ *
+ * @brief Encrypts the given plain text with the given private key
+ *
+ * Since the RSA encryption used in this project is one type, basically
+ * the other encryption function is called. It decrypts the encrypted text with public key.
+ *
+ * C = M^e mod n
+ */
+char* pri_enc(char* m,rsa_key* key){
+	return pub_enc(m,key);
+}
+/**
+ *
+ * @param keys
+ * @param username
+ *
+ * @brief Writes the public key to file with user name
+ *
+ * Since our keys are user based, each person has a key pair, we need to discrete them in a way.
+ * So in this project user names are requested while a pair of RSA key is being created. This way
+ * there will be no mix ups in the keys. The binary key file username_public_key.bin is written too.
+ */
+void write_public_key_to_file(rsa_keys *keys,char* username){
+	FILE *pb_fp;
+	char* filename = (char*)malloc((strlen(username)+20)*sizeof(char));
+	char* bin;
+	strcpy(filename,username);
+	strcat(filename,"_public_key.txt");
+
+	if((pb_fp = fopen(filename,"w")) == NULL){
+		fprintf(stderr,"fopen Failed (write_public_key_to_file)");
+		exit(0);
+	}
+
+	gmp_fprintf(pb_fp,"%Zd\n%Zd\n",keys->pu,keys->n);
+	fclose(pb_fp);
+
+	// the binary key file, it holds the digest of the text file
+	bin = (char*)malloc((strlen(username)+20)*sizeof(char));
+	strcpy(bin,username);
+	strcat(bin,"_public_key.bin");
+	write_key_bin_file(keys,0,filename,bin);
+
+	free(bin);
+	free(filename);
+}
+/**
+ *
+ * @param keys
+ * @param username
+ *
+ * @brief Writes the private key to file with user name
+ *
+ * Since our keys are user based, each person has a key pair, we need to discrete them in a way.
+ * So in this project user names are requested while a pair of RSA key is being created. This way
+ * there will be no mix ups in the keys.
+ *
+ * Next to d and n the private key file holds the CRT components p, q, dp, dq and qinv, one number per line,
+ * so that the private key operations can use the faster CRT path. The binary key file username_private_key.bin,
+ * with the Montgomery constants of n, p and q, is written too.
+ */
+void write_private_key_to_file(rsa_keys *keys,char* username){
+	FILE *pr_fp;
+	char* filename = (char*)malloc((strlen(username)+20)*sizeof(char));
+	char* bin;
+		strcpy(filename,username);
+		strcat(filename,"_private_key.txt");
+
+	if((pr_fp = fopen(filename,"w")) == NULL){
+		fprintf(stderr,"fopen Failed (write_private_key_to_file)");
+		exit(0);
+	}
+
+	gmp_fprintf(pr_fp,"%Zd\n%Zd\n%Zd\n%Zd\n%Zd\n%Zd\n%Zd\n",keys->pr,keys->n,keys->p,keys->q,keys->dp,keys->dq,keys->qinv);
+	fclose(pr_fp);
+
+	// the binary key file, it holds the digest of the text file
+	bin = (char*)malloc((strlen(username)+20)*sizeof(char));
+	strcpy(bin,username);
+	strcat(bin,"_private_key.bin");
+	write_key_bin_file(keys,1,filename,bin);
+
+	free(bin);
+	free(filename);
+}
+/**
+ *
+ * @param s1 String 1
+ * @param s2 String 2
+ * @return Concatenation of s1 and s2 with separator between.
+ *
+ * This function concatenates 2 strings with a separator in between. The separator is 7 # character.
+ * The separator is used for the convenience while extracting the parts.
+ */
+char* concatenate(char* s1,char* s2){
+	size_t conc_size;
+
+	return concatenate_buffer(s1,strlen(s1),s2,&conc_size);
+}
+/**
+ *
+ * @param s1 Data 1
+ * @param s1_size Size of data 1
+ * @param s2 String 2
+ * @param conc_size Size of the concatenation
+ * @return Concatenation of s1 and s2 with separator between.
+ *
+ * Same with concatenate, but the first part is given with its size, so it can be a view into a mapped file
+ * that is not terminated.
+ */
+char* concatenate_buffer(char* s1,size_t s1_size,char* s2,size_t* conc_size){
+	size_t s2_size = strlen(s2);
+	out_buf* conc = create_out_buf(s1_size + 9 + s2_size);
+
+	out_buf_append(conc,s1,s1_size);
+	out_buf_append(conc,"\n#######\n",9);
+	out_buf_append(conc,s2,s2_size);
+
+	return out_buf_release(conc,conc_size);
+}
+/**
+ *
+ * @param filename File
+ * @param size Size of the file content, can be NULL
+ * @return File content
+ *
+ * @brief Gets file content with its size
+ *
+ * File contents is read and put into a character array. The array is terminated with the termination character,
+ * but the content can have zero bytes too (binary ciphered files), so its size is returned.
+ */
+char* read_file_to_buffer(char* filename,size_t* size){
+	FILE *fp;
+	char *str;
+	size_t f_size;
+
+	if((fp = fopen(filename,"rb")) == NULL){
+		fprintf(stderr,"fopen Failed (read_file_to_buffer)");
+		exit(0);
+	}
+
+	//measure the file size
+	fseek(fp, 0, SEEK_END);
+	f_size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+
+	// allocate string according to the file size, plus the termination character
+	str = (char*)malloc((f_size+1)*sizeof(char));
+
+	// start reading the text character by character
+	if(fread(str,1,f_size,fp) != f_size){
+		fprintf(stderr,"fread failed. (read_file_to_buffer)\n");
+		exit(0);
+	}
+	str[f_size] = '\0';
+	if(size != NULL)
+		*size = f_size;
+
+	fclose(fp);
+	return str;
+}
+/**
+ *
+ * @param filename File
+ * @return View of the file content
+ *
+ * @brief Maps the file into the memory.
+ *
+ * The file is not copied, its pages are read by the kernel when they are used. MADV_SEQUENTIAL is only a hint, the
+ * kernel reads further ahead and may reclaim the pages behind the reader sooner under memory pressure. The pages that
+ * are read still count in the resident memory of the process, which grows with the part of the file that is used,
+ * the --stream mode of send_message reads with a fixed amount of memory. The content is not terminated, the size has
+ * to be used.
+ */
+mapped_file* map_file(char* filename){
+	mapped_file* mf = (mapped_file*)malloc(sizeof(mapped_file));
+	struct stat st;
+	int fd;
+
+	if((fd = open(filename,O_RDONLY)) < 0 || fstat(fd,&st) != 0){
+		fprintf(stderr,"open Failed (map_file)");
+		exit(0);
+	}
+
+	mf->size = st.st_size;
+	if(mf->size == 0){// empty files can not be mapped
+		mf->data = "";
+	}
+	else{
+		mf->data = (char*)mmap(NULL,mf->size,PROT_READ,MAP_PRIVATE,fd,0);
+		if(mf->data == MAP_FAILED){
+			fprintf(stderr,"mmap Failed (map_file)");
+			exit(0);
+		}
+		madvise(mf->data,mf->size,MADV_SEQUENTIAL);
+	}
+
+	close(fd);
+	return mf;
+}
+/**
+ *
+ * @param mf Mapped file
+ *
+ * @brief Unmaps the file mapped with map_file.
+ */
+void unmap_file(mapped_file* mf){
+	if(mf->size > 0)
+		munmap(mf->data,mf->size);
+	free(mf);
+}
+/**
+ *
+ * @param filename File
+ * @return File content
+ *
+ * @brief Gets file content
+ *
+ * File contents is read and put into a character array. In the end the character array is returned to user.
+ */
+char* read_file_to_string(char* filename){
+	return read_file_to_buffer(filename,NULL);
+}
+/**
+ *
+ * @param filename File
+ * @param buf The data to be written to the file
+ * @param size Size of the data
+ *
+ * @brief Writes the data to file.
+ *
+ * Writes the given data, which can have zero bytes, to a file with the desired file name. The data is written with
+ * out_buf_flush, in place.
+ */
+void write_buffer_to_file(char* filename,char* buf,size_t size){
+	int fd;
+	// open the file
+	if((fd = open(filename,O_WRONLY|O_CREAT|O_TRUNC,0644)) < 0){
+		fprintf(stderr,"open Failed (write_buffer_to_file)");
+		exit(0);
+	}
+	// write the buffer to the file, it is not copied to the output builder
+	out_buf_flush(NULL,fd,buf,size);
+
+	close(fd);
+}
+/**
+ *
+ * @param filename File
+ * @param str The string to be written to the file
+ *
+ * @brief Writes the string to file.
+ *
+ * Writes the given string to a file with the desired file name.
+ */
+void write_string_to_file(char* filename,char* str){
+	write_buffer_to_file(filename,str,strlen(str));
+}
+/**
+ *
+ * @param filename Key file's name
+ * @return RSA Key
+ *
+ * @brief Read the RSA key from file.
+ *
+ * GMP (GNU Mathematical Precision Library) is used in this project to be able to work with very long
+ *  integers. Mostly the long integers were the keys and encrypted texts. Since we do our exponentiation
+ * with GMP numbers, the key file is read with GMP Library functions for easy manipulation on the number.
+ * A key file has 2 components separated via new line. first part is the e or d and the second part is n.
+ * Our rsa_key structure has k and n elements to hold these values. Private key files may have 5 more
+ * components p, q, dp, dq and qinv for the CRT; if all of them are present the key is marked as a CRT key.
+ * When a binary key file (".bin" instead of ".txt") that was written from this text file is next to it, the binary
+ * file is mapped instead (see key_bin.h). A name without ".txt" is tried as a binary key file first.
+ */
+rsa_key* get_key_from_file(char* filename){
+	char* bin = key_bin_filename(filename);
+	rsa_key* key = NULL;
+
+	// the binary key file is mapped, there is nothing to parse
+	if(bin != NULL && is_key_bin_current(bin,filename))
+		key = map_key_bin_file(bin);
+	else if(bin == NULL)
+		key = map_key_bin_file(filename);
+	free(bin);
+	if(key != NULL)
+		return key;
+
+	key = (rsa_key*)malloc(sizeof(rsa_key));
+	mpz_init(key->k);
+	mpz_init(key->n);
+	mpz_init(key->p);
+	mpz_init(key->q);
+	mpz_init(key->dp);
+	mpz_init(key->dq);
+	mpz_init(key->qinv);
+
+	// read the file and get the content
+	char *key_file_content = read_file_to_string(filename);
+
+	// get keys out of string, public and old private key files only have the first 2 numbers
+	key->crt = gmp_sscanf(key_file_content,"%Zd%Zd%Zd%Zd%Zd%Zd%Zd",key->k,key->n,key->p,key->q,key->dp,key->dq,key->qinv) == 7;
+
+	// precompute the values used by every exponentiation with this key
+	key->ctx = create_rsa_key_ctx(key);
+
+	free(key_file_content);
+	return key;
+}
+/**
+ *
+ * @param id Plain text
+ * @param id_size Size of the plain text
+ * @param pr_key Private Key used for encryption of hash
+ * @return Digital Signature of the given plain text
+ *
+ * @brief Creates the digital signature of the text given with its size.
+ *
+ * Same with create_ds, the plain text can be a view into a mapped file that is not terminated.
+ */
+char* create_ds_of_buffer(char *id,size_t id_size,rsa_key *pr_key){
+	char *hash,*ds;
+
+	hash = create_hash_of_string(id,id_size);
+	ds = pri_enc_packed(hash,strlen(hash),pr_key);
+
+	free(hash);
+	return ds;
+}
+/**
+ *
+ * @param filename File
+ * @param pr_key Private Key used for encryption of hash
+ * @return Digital Signature of the file content
+ *
+ * @brief Creates the digital signature of the file content.
+ *
+ * Same with create_ds, but the file is hashed while it is read piece by piece, it is not kept in the memory.
+ */
+char* create_ds_of_file(char *filename,rsa_key *pr_key){
+	char *hash,*ds;
+
+	hash = create_hash_of_file(filename);
+	ds = pri_enc_packed(hash,strlen(hash),pr_key);
+
+	free(hash);
+	return ds;
+}
+/**
+ *
+ * @param id Plain text
+ * @param pr_key Private Key used for encryption of hash
+ * @return Digital Signature of the given plain text
+ *
+ * @brief Creates the digital signature of the text.
+ *
+ * Digital signature is the encrypted hash of a given text via the owners/senders private key because
+ * the digital signature is unique value to that text. It enables us to be sure about the sent message is valid.
+ * The hash is encrypted in the packed block mode, so it takes a single RSA operation.
+ */
+char* create_ds(char *id,rsa_key *pr_key){
+	return create_ds_of_buffer(id,strlen(id),pr_key);
+}
+/**
+ *
+ * @param prefix Data encrypted before the plain text, can be NULL
+ * @param prefix_size Size of the prefix
+ * @param m Plain Text
+ * @param m_size Size of the plain text
+ * @param suffix Data encrypted after the plain text, not used when pr_key is set
+ * @param suffix_size Size of the suffix
+ * @param sign Creates the suffix from the digest of the plain text when pr_key is set
+ * @param pr_key Sender's private key, if set the suffix is created by sign
+ * @param key Receiver's public key
+ * @param out_size Size of the encrypted data
+ * @return The encrypted message
+ *
+ * @brief Encrypts the prefix, the plain text and the suffix into the binary ciphered file format.
+ *
+ * The output is the same with pub_enc_bin on the concatenation of the prefix, the plain text and the suffix, but the
+ * concatenation is not built. The prefix is put together with the first bytes of the plain text up to a block
+ * boundary, then the rest of the plain text is taken in chunks of FUSED_CHUNK_BLOCKS whole blocks, and each chunk is
+ * encrypted by the block engine. When pr_key is set, each chunk is added to the hash right before it is encrypted,
+ * while it is still in the cache, and the suffix is created from the final digest. The last partial block and the
+ * suffix are encrypted at the end.
+ */
+char* pub_enc_bin_framed(char* prefix,size_t prefix_size,char* m,size_t m_size,char* suffix,size_t suffix_size,
+		suffix_func sign,rsa_key* pr_key,rsa_key* key,size_t* out_size){
+	size_t block_size = packed_block_size(key);
+	size_t width = (mpz_sizeinbase(key->n,BINARY) + 7) / 8; /// bytes of an encrypted block
+	size_t chunk = FUSED_CHUNK_BLOCKS*block_size;
+	size_t head = (block_size - prefix_size % block_size) % block_size; /// plain text bytes that fill the last block of the prefix
+	size_t lead_size,lead_full,full,done,n,tail_size,tail_count;
+	unsigned char sha256sum[32];
+	unsigned char* buf;
+	char *lead,*tail;
+	sha256_context ctx;
+	block_job job;
+
+	if(head > m_size)
+		head = m_size;
+	lead_size = prefix_size + head;
+	lead_full = lead_size / block_size; /// whole blocks of the prefix and the head
+	full = (m_size - head) / block_size; /// whole blocks of the rest of the plain text
+
+	buf = (unsigned char*)malloc((CONTAINER_HEADER_SIZE + (lead_full + full)*width)*sizeof(unsigned char));
+	job.key = key;
+	job.block_size = block_size;
+	job.width = width;
+	get_rsa_key_ctx(key); /// build the context before the workers share it
+
+	sha256_starts(&ctx);
+	lead = (char*)malloc((lead_size+1)*sizeof(char));
+	if(prefix_size > 0)
+		memcpy(lead,prefix,prefix_size);
+	memcpy(lead+prefix_size,m,head);
+	if(pr_key != NULL)
+		sha256_update_buffer(&ctx,m,head);
+	job.in = lead;
+	job.in_size = lead_full*block_size;
+	job.bin = buf + CONTAINER_HEADER_SIZE;
+	run_block_engine(lead_full,pub_enc_bin_block,&job);
+
+	for(done = 0; done < full*block_size; done += n){
+		n = full*block_size - done < chunk ? full*block_size - done : chunk;
+		if(pr_key != NULL)
+			sha256_update_buffer(&ctx,m+head+done,n);
+		job.in = m + head + done;
+		job.in_size = n;
+		job.bin = buf + CONTAINER_HEADER_SIZE + (lead_full + done/block_size)*width;
+		run_block_engine(n/block_size,pub_enc_bin_block,&job);
+	}
+	done += head;
+	if(pr_key != NULL){
+		sha256_update_buffer(&ctx,m+done,m_size-done);
+		sha256_finish(&ctx,sha256sum);
+		suffix = sign(sha256sum,pr_key,&suffix_size);
+	}
+
+	/// the rest of the prefix and the head (only when the plain text is shorter), the rest of the plain text and the suffix
+	tail_size = (lead_size - lead_full*block_size) + (m_size - done) + suffix_size;
+	tail = (char*)malloc((tail_size+1)*sizeof(char));
+	memcpy(tail,lead+lead_full*block_size,lead_size - lead_full*block_size);
+	memcpy(tail+(lead_size - lead_full*block_size),m+done,m_size-done);
+	memcpy(tail+(tail_size - suffix_size),suffix,suffix_size);
+	tail_count = (tail_size + block_size - 1) / block_size;
+
+	*out_size = CONTAINER_HEADER_SIZE + (lead_full + full + tail_count)*width;
+	buf = (unsigned char*)realloc(buf,*out_size*sizeof(unsigned char));
+	put_container_header(buf,CONTAINER_MODE_PACKED,width,lead_full + full + tail_count);
+
+	job.in = tail;
+	job.in_size = tail_size;
+	job.bin = buf + CONTAINER_HEADER_SIZE + (lead_full + full)*width;
+	run_block_engine(tail_count,pub_enc_bin_block,&job);
+
+	if(pr_key != NULL)
+		free(suffix);
+	free(lead);
+	free(tail);
+	return (char*)buf;
+}
+/**
+ *
+ * @param prefix Data encrypted before the plain text, can be NULL
+ * @param prefix_size Size of the prefix
+ * @param m Plain Text
+ * @param m_size Size of the plain text
+ * @param suffix Data encrypted after the plain text, not used when pr_key is set
+ * @param suffix_size Size of the suffix
+ * @param sign Creates the suffix from the digest of the plain text when pr_key is set
+ * @param pr_key Sender's private key, if set the suffix is created by sign
+ * @param key Receiver's public key
+ * @param out_size Size of the encrypted data
+ * @return The encrypted message
+ *
+ * @brief Encrypts the prefix, the plain text and the suffix in the hybrid mode.
+ *
+ * The output is the same with pub_enc_hybrid on the concatenation of the prefix, the plain text and the suffix. When
+ * pr_key is set, each chunk of the plain text is added to the hash and encrypted with ChaCha20 right after, and the
+ * suffix created from the final digest is encrypted last.
+ */
+char* pub_enc_hybrid_framed(char* prefix,size_t prefix_size,char* m,size_t m_size,char* suffix,size_t suffix_size,
+		suffix_func sign,rsa_key* pr_key,rsa_key* key,size_t* out_size){
+	size_t width = (mpz_sizeinbase(key->n,BINARY) + 7) / 8; /// bytes of an encrypted block
+	size_t chunk = FUSED_CHUNK_BLOCKS*CHACHA20_BLOCK_SIZE;
+	size_t done,n;
+	unsigned char sha256sum[32];
+	unsigned char *buf,*body;
+	chacha20_ctx cipher;
+	sha256_context ctx;
+
+	buf = (unsigned char*)malloc((CONTAINER_HEADER_SIZE + width + prefix_size + m_size)*sizeof(unsigned char));
+	start_hybrid(buf,key,&cipher);
+	body = buf + CONTAINER_HEADER_SIZE + width;
+	chacha20_xor(&cipher,(unsigned char*)prefix,body,prefix_size);
+	body += prefix_size;
+
+	sha256_starts(&ctx);
+	for(done = 0; done < m_size; done += n){
+		n = m_size - done < chunk ? m_size - done : chunk;
+		if(pr_key != NULL)
+			sha256_update_buffer(&ctx,m+done,n);
+		chacha20_xor(&cipher,(unsigned char*)m+done,body+done,n);
+	}
+	if(pr_key != NULL){
+		sha256_finish(&ctx,sha256sum);
+		suffix = sign(sha256sum,pr_key,&suffix_size);
+	}
+
+	*out_size = CONTAINER_HEADER_SIZE + width + prefix_size + m_size + suffix_size;
+	buf = (unsigned char*)realloc(buf,*out_size*sizeof(unsigned char));
+	chacha20_xor(&cipher,(unsigned char*)suffix,buf+CONTAINER_HEADER_SIZE+width+prefix_size+m_size,suffix_size);
+
+	memset(&cipher,0,sizeof(cipher));
+	if(pr_key != NULL)
+		free(suffix);
+	return (char*)buf;
+}
+/**
+ *
+ * @param msg Decrypted message sent to the receiver
+ * @return The plain text, NULL if there is no separator in the message
+ *
+ * @brief Separates the plain text.
+ *
+ * Separates the plain text from the concatenation of plain text and digital signature. This operation is done
+ * after the decryption of the received file.
+ */
+char* extract_id(char *msg){
+	int msg_size = strlen(msg);
+	char *id = NULL;
+	int i;
+
+	for (i = 1; i < msg_size-6; ++i) {// the separator has a new line in front of it
+		if(msg[i] == '#' && msg[i+1] == '#' && msg[i+2] == '#' && msg[i+3] == '#' && msg[i+4] == '#' && msg[i+5] == '#' && msg[i+6] == '#'){
+			free(id);
+			id = (char*)malloc(i*sizeof(char));
+			strncpy(id,msg,i);
+			id[i-1] = '\0';
+		}
+	}
+	return id;
+}
+/**
+ *
+ * @param msg Decrypted Message sent to the receiver
+ * @return The digital signature created by the sender, NULL if there is no separator in the message
+ *
+ * @brief Separates the digital signature.
+ *
+ * Separates the digital signature from the concatenation of plain text and digital signature. This operation is done
+ * after the decryption of the received file.
+ */
+char* extract_ds(char *msg){
+	int msg_size = strlen(msg);
+	char *ds = NULL;
+	int i;
+	int ds_start,ds_size;
+
+	for (i = 1; i < msg_size-6; ++i) {// the separator has a new line in front of it
+		if(msg[i] == '#' && msg[i+1] == '#' && msg[i+2] == '#' && msg[i+3] == '#' && msg[i+4] == '#' && msg[i+5] == '#' && msg[i+6] == '#'){
+			free(ds);
+			ds_start = i+8 < msg_size ? i+8 : msg_size; // the separator may be at the end without its new line
+			ds_size = msg_size - ds_start + 1;
+			ds = (char*)malloc(ds_size*sizeof(char));
+			strncpy(ds,(msg+ds_start),ds_size);
+
+		}
+	}
+	return ds;
+}
+/**
+ *
+ * @param argc Argument count, the option is removed from it
+ * @param argv Arguments, the option is removed from them
+ * @param flag The option, e.g. "--stream"
+ * @return true(1) if the option is given, false(0) otherwise
+ *
+ * @brief Looks for an option without a value and removes it from the arguments.
+ */
+int parse_flag_option(int* argc,char** argv,char* flag){
+	int i,j;
+
+	for(i = 1; i < *argc; i++){
+		if(strcmp(argv[i],flag) == 0){
+			for(j = i; j + 1 < *argc; j++)
+				argv[j] = argv[j+1];
+			(*argc)--;
+			return 1;
+		}
+	}
+	return 0;
+}
+/**
+ *
+ * @param argc Argument count, the option is removed from it
+ * @param argv Arguments, the option is removed from them
+ * @param option The option, e.g. "--exponent"
+ * @return The value of the option, NULL if the option is not given
+ *
+ * @brief Looks for an option with a value and removes both from the arguments.
+ */
+char* parse_value_option(int* argc,char** argv,char* option){
+	char* value;
+	int i,j;
+
+	for(i = 1; i < *argc; i++){
+		if(strcmp(argv[i],option) == 0){
+			if(i + 1 >= *argc){
+				fprintf(stderr,"%s needs a value\n",option);
+				exit(0);
+			}
+			value = argv[i+1];
+			for(j = i; j + 2 < *argc; j++)
+				argv[j] = argv[j+2];
+			*argc -= 2;
+			return value;
+		}
+	}
+	return NULL;
+}
+/**
+ *
+ * @param hash1 Hash value value
+ * @param hash2 Other hash value
+ * @return true(1) on success or false(0) on failure
+ *
+ * @brief Authenticates the hash values are the same or not.
+ *
+ * Compares the hash values and decides if the sent message is not played on its way to the receiver.
+ */
+int authenticate(char* hash1,char* hash2){
+	int hash_size = strlen(hash1);
+	int i;
+	int flag = 1;
+
+	for (i = 0; i < hash_size; ++i) {
+		if(hash1[i] != hash2[i]){
+			flag = 0;
+		}
+	}
+	return flag;
+}
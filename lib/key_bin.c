@@ -0,0 +1,304 @@
+/**
+ * @file
+ * @brief Writing and mapping the binary key files.
+ */
+
+#include "key_bin.h"
+
+/**
+ *
+ * @param txt Name of the text key file
+ * @param size Output, size of the file
+ * @param sha256sum Output, 32 byte digest of the file
+ * @return true(1) if the file is read, false(0) otherwise
+ *
+ * @brief Hashes the text key file, the binary key file is tied to the text file with it.
+ */
+int key_bin_source_digest(char* txt,uint64_t* size,unsigned char* sha256sum){
+	unsigned char buf[4096];
+	sha256_context ctx;
+	size_t len;
+	FILE* fp;
+
+	if((fp = fopen(txt,"rb")) == NULL)
+		return 0;
+	*size = 0;
+	sha256_starts(&ctx);
+	while((len = fread(buf,1,sizeof(buf),fp)) > 0){
+		sha256_update(&ctx,buf,len);
+		*size += len;
+	}
+	sha256_finish(&ctx,sha256sum);
+	fclose(fp);
+	return 1;
+}
+/**
+ *
+ * @param fp The file
+ * @param header Header of the file, the offset and the limb count of the field are set
+ * @param field Index of the number
+ * @param limbs Limbs of the number, least significant first
+ * @param count Number of the limbs
+ *
+ * @brief Writes the limbs at the end of the file, from the next page boundary.
+ */
+void write_key_bin_limbs(FILE* fp,key_bin_header* header,int field,const mp_limb_t* limbs,size_t count){
+	long pos = ftell(fp);
+	long aligned = (pos + KEY_BIN_PAGE - 1) / KEY_BIN_PAGE * KEY_BIN_PAGE;
+
+	for(; pos < aligned; pos++)
+		fputc(0,fp);
+	header->offset[field] = aligned;
+	header->limbs[field] = count;
+	if(count > 0 && fwrite(limbs,sizeof(mp_limb_t),count,fp) != count){
+		fprintf(stderr,"fwrite Failed (write_key_bin_limbs)");
+		exit(0);
+	}
+}
+/**
+ *
+ * @param fp The file
+ * @param header Header of the file, the number's offset and limb count are set
+ * @param field Index of the number
+ * @param num The number
+ *
+ * @brief Writes the limbs of the number at the end of the file, from the next page boundary.
+ */
+void write_key_bin_field(FILE* fp,key_bin_header* header,int field,mpz_t num){
+	write_key_bin_limbs(fp,header,field,mpz_limbs_read(num),mpz_size(num));
+}
+/**
+ *
+ * @param fp The file
+ * @param header Header of the file
+ * @param field Index of R^2 mod m
+ * @param ninv Index of n' in the header
+ * @param mod Modulo number
+ *
+ * @brief Computes and writes the Montgomery constants of the modulo number.
+ */
+void write_key_bin_mont(FILE* fp,key_bin_header* header,int field,int ninv,mpz_t mod){
+	mont_ctx* ctx = create_mont_ctx(mod);
+
+	if(ctx == NULL){// even modulo numbers have no constants
+		write_key_bin_limbs(fp,header,field,NULL,0);
+		header->ninv[ninv] = 0;
+		return;
+	}
+	// all the limbs of R^2 are written, with its high zero limbs, the mapped context uses ctx->size limbs
+	write_key_bin_limbs(fp,header,field,ctx->r2,ctx->size);
+	header->ninv[ninv] = ctx->ninv;
+	free_mont_ctx(ctx);
+}
+/**
+ *
+ * @param keys The keys
+ * @param private_key 1 for the private key file, 0 for the public key file
+ * @param txt Name of the text key file of the same key, it is written before the binary file
+ * @param filename Name of the binary key file
+ *
+ * @brief Writes the public or private key to a binary key file.
+ *
+ * The public key file has e, n and the constants of n. The private key file also has the CRT components and the
+ * constants of p and q. The size and the digest of the text file are put in the header.
+ */
+void write_key_bin_file(rsa_keys* keys,int private_key,char* txt,char* filename){
+	key_bin_header header;
+	FILE* fp;
+
+	if((fp = fopen(filename,"wb")) == NULL){
+		fprintf(stderr,"fopen Failed (write_key_bin_file)");
+		exit(0);
+	}
+
+	memset(&header,0,sizeof(header));
+	memcpy(header.magic,KEY_BIN_MAGIC,sizeof(KEY_BIN_MAGIC));
+	header.version = KEY_BIN_VERSION;
+	header.limb_size = sizeof(mp_limb_t);
+	header.byte_order = KEY_BIN_BYTE_ORDER;
+	header.crt = private_key;
+	if(!key_bin_source_digest(txt,&header.txt_size,header.txt_sha256)){
+		fprintf(stderr,"The text key file can not be read (write_key_bin_file)");
+		exit(0);
+	}
+
+	fseek(fp,KEY_BIN_PAGE,SEEK_SET); // the header is written last, on the first page
+	write_key_bin_field(fp,&header,KEY_BIN_K,private_key ? keys->pr : keys->pu);
+	write_key_bin_field(fp,&header,KEY_BIN_N,keys->n);
+	write_key_bin_mont(fp,&header,KEY_BIN_R2_N,0,keys->n);
+	if(private_key){
+		write_key_bin_field(fp,&header,KEY_BIN_P,keys->p);
+		write_key_bin_field(fp,&header,KEY_BIN_Q,keys->q);
+		write_key_bin_field(fp,&header,KEY_BIN_DP,keys->dp);
+		write_key_bin_field(fp,&header,KEY_BIN_DQ,keys->dq);
+		write_key_bin_field(fp,&header,KEY_BIN_QINV,keys->qinv);
+		write_key_bin_mont(fp,&header,KEY_BIN_R2_P,1,keys->p);
+		write_key_bin_mont(fp,&header,KEY_BIN_R2_Q,2,keys->q);
+	}
+
+	fseek(fp,0,SEEK_SET);
+	if(fwrite(&header,sizeof(header),1,fp) != 1){
+		fprintf(stderr,"fwrite Failed (write_key_bin_file)");
+		exit(0);
+	}
+	fclose(fp);
+}
+/**
+ *
+ * @param header Header of the file
+ * @param size Size of the file
+ * @return true(1) if the file can be used on this machine, false(0) otherwise
+ *
+ * @brief Checks the header, the limb size, the byte order and the bounds of the numbers.
+ */
+int check_key_bin_header(const key_bin_header* header,size_t size){
+	int i;
+
+	if(size < sizeof(key_bin_header) || memcmp(header->magic,KEY_BIN_MAGIC,sizeof(KEY_BIN_MAGIC)) != 0)
+		return 0;
+	if(header->version != KEY_BIN_VERSION || header->limb_size != sizeof(mp_limb_t) || header->byte_order != KEY_BIN_BYTE_ORDER)
+		return 0;
+	for(i = 0; i < KEY_BIN_FIELDS; i++){
+		if(header->offset[i] % KEY_BIN_PAGE != 0 || header->offset[i] > size
+				|| header->limbs[i] > (size - header->offset[i]) / sizeof(mp_limb_t))
+			return 0;
+	}
+	return 1;
+}
+/**
+ *
+ * @param base Start of the mapped file
+ * @param header Header of the file
+ * @param field Index of R^2 mod m
+ * @param ninv Index of n' in the header
+ * @param mod The modulo number, it points into the file
+ * @return Montgomery constants that point into the file, NULL if the file has none for this modulo number
+ *
+ * @brief Makes the Montgomery constants of the modulo number point into the file.
+ *
+ * R^2 mod m is used as a number of exactly the limb count of the modulo number, so a field with another count is
+ * not used.
+ */
+mont_ctx* map_key_bin_mont(const char* base,const key_bin_header* header,int field,int ninv,mpz_t mod){
+	mont_ctx* ctx;
+
+	if(header->ninv[ninv] == 0 || header->limbs[field] != mpz_size(mod))
+		return NULL;
+	ctx = (mont_ctx*)malloc(sizeof(mont_ctx));
+	mpz_roinit_n(ctx->n,mpz_limbs_read(mod),mpz_size(mod));
+	ctx->r2 = (mp_limb_t*)(base + header->offset[field]);
+	ctx->ninv = header->ninv[ninv];
+	ctx->size = mpz_size(mod);
+	ctx->mapped = 1;
+	return ctx;
+}
+/**
+ *
+ * @param filename Name of the binary key file
+ * @return The key, NULL if the file can not be opened or was written on another kind of machine
+ *
+ * @brief Maps the binary key file and makes the key and its context point into it.
+ *
+ * The numbers of the key are read only GMP numbers on the mapped pages, so they must not be changed or cleared.
+ * Only the recoded exponents of the context are computed, the Montgomery constants come from the file. The file
+ * stays mapped for the life of the process, like the keys which are read from the text files.
+ */
+rsa_key* map_key_bin_file(char* filename){
+	const key_bin_header* header;
+	rsa_key_ctx* ctx;
+	rsa_key* key;
+	struct stat st;
+	char* base;
+	int fd;
+
+	if((fd = open(filename,O_RDONLY)) < 0)
+		return NULL;
+	if(fstat(fd,&st) != 0 || (size_t)st.st_size < sizeof(key_bin_header)){
+		close(fd);
+		return NULL;
+	}
+	base = (char*)mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+	close(fd);
+	if(base == MAP_FAILED)
+		return NULL;
+
+	header = (const key_bin_header*)base;
+	if(!check_key_bin_header(header,st.st_size)){
+		munmap(base,st.st_size);
+		return NULL;
+	}
+
+#define KEY_BIN_NUM(num,field) mpz_roinit_n(num,(const mp_limb_t*)(base + header->offset[field]),header->limbs[field])
+	key = (rsa_key*)malloc(sizeof(rsa_key));
+	KEY_BIN_NUM(key->k,KEY_BIN_K);
+	KEY_BIN_NUM(key->n,KEY_BIN_N);
+	KEY_BIN_NUM(key->p,KEY_BIN_P);
+	KEY_BIN_NUM(key->q,KEY_BIN_Q);
+	KEY_BIN_NUM(key->dp,KEY_BIN_DP);
+	KEY_BIN_NUM(key->dq,KEY_BIN_DQ);
+	KEY_BIN_NUM(key->qinv,KEY_BIN_QINV);
+#undef KEY_BIN_NUM
+	key->crt = header->crt && mpz_sgn(key->p) != 0 && mpz_sgn(key->q) != 0;
+
+	ctx = (rsa_key_ctx*)malloc(sizeof(rsa_key_ctx));
+	ctx->n = map_key_bin_mont(base,header,KEY_BIN_R2_N,0,key->n);
+	ctx->k = recode_exponent(key->k);
+	if(key->crt){
+		ctx->p = map_key_bin_mont(base,header,KEY_BIN_R2_P,1,key->p);
+		ctx->q = map_key_bin_mont(base,header,KEY_BIN_R2_Q,2,key->q);
+		ctx->dp = recode_exponent(key->dp);
+		ctx->dq = recode_exponent(key->dq);
+	}
+	else{
+		ctx->p = NULL;
+		ctx->q = NULL;
+		ctx->dp = NULL;
+		ctx->dq = NULL;
+	}
+	key->ctx = ctx;
+	return key;
+}
+/**
+ *
+ * @param filename Name of the text key file
+ * @return Name of the binary key file next to it, NULL if the name does not end with ".txt"
+ */
+char* key_bin_filename(char* filename){
+	size_t len = strlen(filename);
+	char* bin;
+
+	if(len < 4 || strcmp(filename+len-4,".txt") != 0)
+		return NULL;
+	bin = (char*)malloc((len+1)*sizeof(char));
+	memcpy(bin,filename,len-4);
+	strcpy(bin+len-4,".bin");
+	return bin;
+}
+/**
+ *
+ * @param bin Name of the binary key file
+ * @param txt Name of the text key file
+ * @return true(1) if the binary file was written from the text file as it is now, or there is no text file, false(0) otherwise
+ *
+ * @brief A text file that is changed after the binary file was written is used instead of the stale binary file.
+ *
+ * The size and the digest of the text file are compared with the ones in the binary file's header. The modification
+ * times are not used, a text file that is replaced with an older copy has an older time than the binary file.
+ */
+int is_key_bin_current(char* bin,char* txt){
+	key_bin_header header;
+	unsigned char sha256sum[32];
+	uint64_t size;
+	FILE* fp;
+	int ok;
+
+	if((fp = fopen(bin,"rb")) == NULL)
+		return 0;
+	ok = fread(&header,sizeof(header),1,fp) == 1;
+	fclose(fp);
+	if(!ok || memcmp(header.magic,KEY_BIN_MAGIC,sizeof(KEY_BIN_MAGIC)) != 0 || header.version != KEY_BIN_VERSION)
+		return 0;
+	if(!key_bin_source_digest(txt,&size,sha256sum))
+		return 1;
+	return size == header.txt_size && memcmp(sha256sum,header.txt_sha256,32) == 0;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file
+ * @brief Binary key files which are loaded with mmap.
+ *
+ * The text key files hold decimal numbers, so each run converts them to binary with gmp_sscanf. The binary key file
+ * holds the same numbers as GMP limbs in the native layout of the machine, with the Montgomery constants of the
+ * moduli. Each number starts on its own page, so the file is mapped and the numbers are used in place with
+ * mpz_roinit_n, there is no parsing and no copy.
+ *
+ * The first page is the header: the magic, the limb size, a byte order mark, and the offset and limb count of each
+ * number. A file written on a machine with another limb size or byte order is not used, the text file is read instead.
+ * The header also has the size and the SHA256 digest of the text file the binary file was written with. When the
+ * text file next to it has another size or content, the binary file is stale and the text file is read instead,
+ * whatever the modification times of the files are.
+ */
+
+#ifndef KEY_BIN_H_
+#define KEY_BIN_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <gmp.h>
+#include "sha256.h"
+#include "rsa_opts.h"
+
+/**
+ * First bytes of a binary key file.
+ */
+#define KEY_BIN_MAGIC "RMXKEY1"
+/**
+ * Version of the binary key file format.
+ */
+#define KEY_BIN_VERSION 2
+/**
+ * The numbers are aligned to this many bytes, it is a multiple of the page size of the common machines.
+ */
+#define KEY_BIN_PAGE 4096
+/**
+ * Written as a 64 bit number, it shows the byte order of the machine that wrote the file.
+ */
+#define KEY_BIN_BYTE_ORDER 0x0102030405060708ULL
+
+/**
+ * Indexes of the numbers in the binary key file.
+ */
+enum KEY_BIN_FIELD {
+	KEY_BIN_K, // e or d
+	KEY_BIN_N,
+	KEY_BIN_P,
+	KEY_BIN_Q,
+	KEY_BIN_DP,
+	KEY_BIN_DQ,
+	KEY_BIN_QINV,
+	KEY_BIN_R2_N, // R^2 mod n
+	KEY_BIN_R2_P, // R^2 mod p
+	KEY_BIN_R2_Q, // R^2 mod q
+	KEY_BIN_FIELDS
+};
+
+/**
+ * @struct KEY_BIN_HEADER
+ * @brief KEY_BIN_HEADER is the first page of a binary key file.
+ */
+typedef struct KEY_BIN_HEADER {
+	char magic[8]; // KEY_BIN_MAGIC
+	uint32_t version; // KEY_BIN_VERSION
+	uint32_t limb_size; // sizeof(mp_limb_t) of the writer
+	uint64_t byte_order; // KEY_BIN_BYTE_ORDER in the byte order of the writer
+	uint32_t crt; // 1 if the CRT components are in the file
+	uint32_t reserved;
+	uint64_t offset[KEY_BIN_FIELDS]; // offset of each number, a multiple of KEY_BIN_PAGE
+	uint64_t limbs[KEY_BIN_FIELDS]; // limb count of each number, 0 for zero or a missing number
+	uint64_t ninv[3]; // n' = -m^-1 mod 2^GMP_NUMB_BITS of n, p and q, 0 if the modulo number has no Montgomery constants
+	uint64_t txt_size; // size of the text key file
+	unsigned char txt_sha256[32]; // SHA256 digest of the text key file
+}key_bin_header;
+
+void write_key_bin_limbs(FILE* fp,key_bin_header* header,int field,const mp_limb_t* limbs,size_t count);
+void write_key_bin_field(FILE* fp,key_bin_header* header,int field,mpz_t num);
+void write_key_bin_mont(FILE* fp,key_bin_header* header,int field,int ninv,mpz_t mod);
+int key_bin_source_digest(char* txt,uint64_t* size,unsigned char* sha256sum);
+void write_key_bin_file(rsa_keys* keys,int private_key,char* txt,char* filename);
+int check_key_bin_header(const key_bin_header* header,size_t size);
+mont_ctx* map_key_bin_mont(const char* base,const key_bin_header* header,int field,int ninv,mpz_t mod);
+rsa_key* map_key_bin_file(char* filename);
+char* key_bin_filename(char* filename);
+int is_key_bin_current(char* bin,char* txt);
+
+#endif /* KEY_BIN_H_ */
@@ -0,0 +1,279 @@
+/**
+ * @file
+ * @brief The key pool service and the claims of the pooled keys.
+ */
+
+#include "key_pool.h"
+
+/**
+ *
+ * @param path Directory
+ *
+ * @brief Creates the directory if it does not exist, only the owner can access it since it holds private keys.
+ */
+void key_pool_mkdir(char* path){
+	if(mkdir(path,0700) != 0 && errno != EEXIST){
+		fprintf(stderr,"mkdir failed for %s (key_pool_mkdir)\n",path);
+		exit(0);
+	}
+}
+/**
+ *
+ * @param pool_dir Spool directory
+ * @param key_length Key length in bits
+ * @param e Public exponent, 0 for a random one
+ * @return Directory of the key size as a string
+ */
+char* key_pool_size_dir(char* pool_dir,int key_length,unsigned long e){
+	char* dir = (char*)malloc((strlen(pool_dir)+64)*sizeof(char));
+
+	sprintf(dir,"%s/%d_%lu",pool_dir,key_length,e);
+	return dir;
+}
+/**
+ *
+ * @param size_dir Directory of the key size
+ * @return Number of ready key pairs
+ */
+int key_pool_count(char* size_dir){
+	DIR* dp;
+	struct dirent* ent;
+	int count = 0;
+
+	if((dp = opendir(size_dir)) == NULL)
+		return 0;
+	while((ent = readdir(dp)) != NULL){
+		if(ent->d_name[0] != '.') // hidden ones are being written or claimed
+			count++;
+	}
+	closedir(dp);
+	return count;
+}
+/**
+ *
+ * @param pool_dir Spool directory
+ * @param key_length Key length in bits
+ * @param e Public exponent, 0 for a random one
+ *
+ * @brief Generates one key pair and publishes it in the pool.
+ *
+ * The files are written with write_public_key_to_file and write_private_key_to_file with the directory as the
+ * username, so the pair holds the same files that create_rsa_keys writes, without the username in front.
+ */
+void key_pool_add(char* pool_dir,int key_length,unsigned long e){
+	char* size_dir = key_pool_size_dir(pool_dir,key_length,e);
+	char* tmp_dir = (char*)malloc((strlen(size_dir)+16)*sizeof(char));
+	char* ready_dir = (char*)malloc((strlen(size_dir)+64)*sizeof(char));
+	char* prefix = (char*)malloc((strlen(size_dir)+16)*sizeof(char));
+	static unsigned long serial = 0;
+	rsa_key_base* key_base;
+	rsa_keys* keys;
+
+	key_pool_mkdir(pool_dir);
+	key_pool_mkdir(size_dir);
+	sprintf(tmp_dir,"%s/.tmpXXXXXX",size_dir);
+	if(mkdtemp(tmp_dir) == NULL){
+		fprintf(stderr,"mkdtemp failed (key_pool_add)\n");
+		exit(0);
+	}
+	sprintf(prefix,"%s/",tmp_dir);
+
+	key_base = generate_rsa_key_base_e(key_length,e);
+	keys = create_pub_key(key_base);
+	write_public_key_to_file(keys,prefix);
+	write_private_key_to_file(keys,prefix);
+
+	// publish the complete pair
+	sprintf(ready_dir,"%s/k%ld_%d_%lu",size_dir,(long)time(NULL),(int)getpid(),serial++);
+	if(rename(tmp_dir,ready_dir) != 0){
+		fprintf(stderr,"rename failed (key_pool_add)\n");
+		exit(0);
+	}
+
+	free_rsa_key_base(key_base);
+	free_rsa_keys(keys);
+	free(prefix);
+	free(ready_dir);
+	free(tmp_dir);
+	free(size_dir);
+}
+/**
+ *
+ * @param dir Directory of a key pair
+ *
+ * @brief Removes the files in the directory and the directory.
+ */
+void key_pool_remove_dir(char* dir){
+	DIR* dp;
+	struct dirent* ent;
+	char* path;
+
+	if((dp = opendir(dir)) == NULL)
+		return;
+	while((ent = readdir(dp)) != NULL){
+		if(strcmp(ent->d_name,".") == 0 || strcmp(ent->d_name,"..") == 0)
+			continue;
+		path = (char*)malloc((strlen(dir)+strlen(ent->d_name)+2)*sizeof(char));
+		sprintf(path,"%s/%s",dir,ent->d_name);
+		unlink(path);
+		free(path);
+	}
+	closedir(dp);
+	rmdir(dir);
+}
+/**
+ *
+ * @param size_dir Directory of the key size
+ * @return Number of the removed claims
+ *
+ * @brief Removes the claimed pairs whose claimer is not running, they hold private keys that nobody will move out.
+ */
+int key_pool_remove_stale_claims(char* size_dir){
+	DIR* dp;
+	struct dirent* ent;
+	char* path;
+	long pid;
+	int removed = 0;
+
+	if((dp = opendir(size_dir)) == NULL)
+		return 0;
+	while((ent = readdir(dp)) != NULL){
+		if(strncmp(ent->d_name,KEY_POOL_CLAIMED,strlen(KEY_POOL_CLAIMED)) != 0)
+			continue;
+		pid = strtol(ent->d_name+strlen(KEY_POOL_CLAIMED),NULL,10);
+		if(pid <= 0 || kill((pid_t)pid,0) == 0 || errno != ESRCH)
+			continue; // the claimer is running, or it belongs to another user
+		path = (char*)malloc((strlen(size_dir)+strlen(ent->d_name)+2)*sizeof(char));
+		sprintf(path,"%s/%s",size_dir,ent->d_name);
+		key_pool_remove_dir(path);
+		free(path);
+		removed++;
+	}
+	closedir(dp);
+	return removed;
+}
+/**
+ *
+ * @param pool_dir Spool directory
+ * @param key_lengths Key lengths in bits
+ * @param count Number of key lengths
+ * @param e Public exponent, 0 for a random one
+ * @param watermark Number of ready key pairs to keep for each key length
+ *
+ * @brief Runs the pool service, it never returns.
+ *
+ * The pool is filled up to the watermark, then checked again every KEY_POOL_POLL_SECONDS seconds for the claimed
+ * pairs. The key sizes are filled one pair at a time in turn, so a burst on one size does not starve the others.
+ * The stale claims are removed at each check.
+ */
+void run_key_pool(char* pool_dir,int* key_lengths,int count,unsigned long e,int watermark){
+	int i,added;
+
+	while(1){
+		for(i = 0; i < count; i++){
+			char* size_dir = key_pool_size_dir(pool_dir,key_lengths[i],e);
+			key_pool_remove_stale_claims(size_dir);
+			free(size_dir);
+		}
+		do {
+			added = 0;
+			for(i = 0; i < count; i++){
+				char* size_dir = key_pool_size_dir(pool_dir,key_lengths[i],e);
+				if(key_pool_count(size_dir) < watermark){
+					key_pool_add(pool_dir,key_lengths[i],e);
+					added++;
+				}
+				free(size_dir);
+			}
+		}while(added > 0);
+		sleep(KEY_POOL_POLL_SECONDS);
+	}
+}
+/**
+ *
+ * @param from File in the claimed pair
+ * @param to File of the user
+ *
+ * @brief Moves the file, with a copy when the pool is on another file system.
+ */
+void key_pool_move(char* from,char* to){
+	size_t size;
+	char* buf;
+
+	if(rename(from,to) == 0)
+		return;
+	if(errno != EXDEV){
+		fprintf(stderr,"rename failed for %s (key_pool_move)\n",from);
+		exit(0);
+	}
+	buf = read_file_to_buffer(from,&size);
+	write_buffer_to_file(to,buf,size);
+	free(buf);
+	unlink(from);
+}
+/**
+ *
+ * @param pool_dir Spool directory
+ * @param key_length Key length in bits
+ * @param e Public exponent, 0 for a random one
+ * @param username Owner of the keys
+ * @return true(1) if a pair is claimed, false(0) if the pool has no ready pair of this size
+ *
+ * @brief Claims a ready key pair and moves its files to username_public_key.txt and username_private_key.txt.
+ *
+ * The pair's directory is renamed to a name of this process first. When another process renames it first, the rename
+ * fails and the next pair is tried.
+ */
+int claim_pooled_keys(char* pool_dir,int key_length,unsigned long e,char* username){
+	char* size_dir = key_pool_size_dir(pool_dir,key_length,e);
+	char *from,*to,*claimed = NULL;
+	DIR *dp,*cp;
+	struct dirent *ent,*file;
+	int found = 0;
+
+	if((dp = opendir(size_dir)) == NULL){
+		free(size_dir);
+		return 0;
+	}
+	while(!found && (ent = readdir(dp)) != NULL){
+		if(ent->d_name[0] == '.')
+			continue;
+		from = (char*)malloc((strlen(size_dir)+strlen(ent->d_name)+2)*sizeof(char));
+		claimed = (char*)malloc((strlen(size_dir)+strlen(ent->d_name)+64)*sizeof(char));
+		sprintf(from,"%s/%s",size_dir,ent->d_name);
+		sprintf(claimed,"%s/" KEY_POOL_CLAIMED "%d_%s",size_dir,(int)getpid(),ent->d_name);
+		if(rename(from,claimed) == 0)
+			found = 1;
+		else{
+			free(claimed);
+			claimed = NULL;
+		}
+		free(from);
+	}
+	closedir(dp);
+
+	if(found){
+		do {// the directory is read again until the files are all moved out
+			if((cp = opendir(claimed)) == NULL){
+				fprintf(stderr,"opendir failed (claim_pooled_keys)\n");
+				exit(0);
+			}
+			while((file = readdir(cp)) != NULL){
+				if(strcmp(file->d_name,".") == 0 || strcmp(file->d_name,"..") == 0)
+					continue;
+				from = (char*)malloc((strlen(claimed)+strlen(file->d_name)+2)*sizeof(char));
+				to = (char*)malloc((strlen(username)+strlen(file->d_name)+1)*sizeof(char));
+				sprintf(from,"%s/%s",claimed,file->d_name);
+				sprintf(to,"%s%s",username,file->d_name); // "_public_key.txt" gets the username in front
+				key_pool_move(from,to);
+				free(from);
+				free(to);
+			}
+			closedir(cp);
+		}while(rmdir(claimed) != 0 && errno == ENOTEMPTY);
+		free(claimed);
+	}
+
+	free(size_dir);
+	return found;
+}
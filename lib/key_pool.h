@@ -0,0 +1,58 @@
+/**
+ * @file
+ * @brief Pool of pre-generated RSA key pairs.
+ *
+ * The key generation takes seconds for the large keys, so a new user waits for it. The pool service generates key
+ * pairs in the background and keeps up to a watermark of ready pairs for each key size in a spool directory. Then
+ * create_rsa_keys claims a ready pair instead of generating one.
+ *
+ * Each key size and public exponent has its own directory, "bits_e", in the spool directory. A pair is written to a
+ * hidden ".tmp" directory first and published with a rename, so a half written pair is never seen. A pair is claimed
+ * by renaming its directory to a hidden ".claimed" name. Only one of the processes racing for the same pair can
+ * do this rename, so the same pair is never given to two users. The claimed name holds the claimer's process id, and
+ * the service removes the claims whose process is gone, so a claimer that dies does not leave private keys behind.
+ */
+
+#ifndef KEY_POOL_H_
+#define KEY_POOL_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "rsa_opts.h"
+#include "general_opts.h"
+
+/**
+ * Default spool directory of the pool.
+ */
+#define KEY_POOL_DIR "key_pool"
+/**
+ * Default number of ready key pairs kept for each key size.
+ */
+#define KEY_POOL_WATERMARK 8
+/**
+ * Seconds between two checks of the pool service.
+ */
+#define KEY_POOL_POLL_SECONDS 5
+/**
+ * Name prefix of a claimed pair's directory, it is followed by the claimer's process id.
+ */
+#define KEY_POOL_CLAIMED ".claimed_"
+
+void key_pool_mkdir(char* path);
+char* key_pool_size_dir(char* pool_dir,int key_length,unsigned long e);
+int key_pool_count(char* size_dir);
+void key_pool_add(char* pool_dir,int key_length,unsigned long e);
+void key_pool_remove_dir(char* dir);
+int key_pool_remove_stale_claims(char* size_dir);
+void run_key_pool(char* pool_dir,int* key_lengths,int count,unsigned long e,int watermark);
+void key_pool_move(char* from,char* to);
+int claim_pooled_keys(char* pool_dir,int key_length,unsigned long e,char* username);
+
+#endif /* KEY_POOL_H_ */
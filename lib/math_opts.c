@@ -0,0 +1,973 @@
+/**
+ * @file
+ * @brief Prime generation, Blum Blum Shub engine and modular exponentiation.
+ */
+
+#include "math_opts.h"
+
+/**
+ *
+ * @param bits Bit length of the prime
+ * @return Number of Miller-Rabin rounds
+ *
+ * @brief Number of Miller-Rabin rounds for a random prime candidate of the given bit length.
+ *
+ * The rounds follow the FIPS 186-4 table C.3 for the primes of RSA keys, for an error probability of at most
+ * 2^-100 (512 bits), 2^-112 (1024 bits) and 2^-128 (1536 bits and more). Smaller primes get more rounds.
+ */
+int miller_rabin_rounds(size_t bits){
+	if(bits >= 1536)
+		return 4;
+	if(bits >= 1024)
+		return 5;
+	if(bits >= 512)
+		return 7;
+	return 40;
+}
+/**
+ *
+ * @param n Odd number greater than 3
+ * @param rounds Number of rounds
+ * @param state Random state for the bases
+ * @return True(1): Probably prime or False(0): Composite
+ *
+ * @brief Miller-Rabin probable prime test with random bases.
+ */
+int miller_rabin(mpz_t n,int rounds,gmp_randstate_t state){
+	mpz_t n_1,d,a,x,range;
+	unsigned long s,j;
+	int i,prime = 1;
+
+	mpz_init(n_1);
+	mpz_init(d);
+	mpz_init(a);
+	mpz_init(x);
+	mpz_init(range);
+
+	mpz_sub_ui(n_1,n,1);
+	s = mpz_scan1(n_1,0);
+	mpz_tdiv_q_2exp(d,n_1,s); /// n - 1 = d x 2^s
+	mpz_sub_ui(range,n,3);
+
+	for(i = 0; i < rounds && prime; i++){
+		mpz_urandomm(a,state,range);
+		mpz_add_ui(a,a,2); /// 2 <= a <= n - 2
+		mpz_powm(x,a,d,n);
+		if(mpz_cmp_ui(x,1) == 0 || mpz_cmp(x,n_1) == 0)
+			continue;
+		for(j = 1; j < s; j++){
+			mpz_powm_ui(x,x,2,n);
+			if(mpz_cmp(x,n_1) == 0)
+				break;
+		}
+		if(j == s)
+			prime = 0;
+	}
+
+	mpz_clear(n_1);
+	mpz_clear(d);
+	mpz_clear(a);
+	mpz_clear(x);
+	mpz_clear(range);
+	return prime;
+}
+/**
+ *
+ * @param composite Marks of the window, set for the candidates with a small factor
+ * @param base First candidate of the window, odd
+ *
+ * @brief Sieves a window of PRIME_SIEVE_WINDOW odd candidates base, base + 2, ... with the small prime table.
+ *
+ * The remainder of base is computed once for each prime of the table, and the multiples of that prime are crossed
+ * out in the window.
+ */
+void sieve_prime_window(unsigned char* composite,mpz_t base){
+	unsigned long p,r,k;
+	size_t i;
+
+	memset(composite,0,PRIME_SIEVE_WINDOW);
+	for(i = 0; i < SMALL_PRIME_COUNT; i++){
+		p = small_primes[i];
+		r = mpz_fdiv_ui(base,p);
+		// base + 2k = 0 mod p  =>  k = -r / 2 mod p
+		k = r == 0 ? 0 : ((p - r) * ((p + 1) / 2)) % p;
+		for(; k < PRIME_SIEVE_WINDOW; k += p)
+			composite[k] = 1;
+	}
+}
+/**
+ *
+ * @param state Random state to seed
+ *
+ * @brief Seeds a GMP random state from the thread's random source, for the Miller-Rabin bases.
+ */
+void seed_prime_randstate(gmp_randstate_t state){
+	unsigned char seed[32];
+	mpz_t s;
+
+	mpz_init(s);
+	gmp_randinit_default(state);
+	rand_bytes(get_thread_rand_source(),seed,sizeof(seed));
+	mpz_import(s,sizeof(seed),1,1,0,0,seed);
+	gmp_randseed(state,s);
+	mpz_clear(s);
+}
+/**
+ *
+ * @param rop The prime
+ * @param start The prime is greater than this number
+ *
+ * @brief Finds the first probable prime greater than the given number, like mpz_nextprime.
+ *
+ * The odd candidates are taken in windows of PRIME_SIEVE_WINDOW and sieved with sieve_prime_window.
+ * Only the candidates left get the Miller-Rabin rounds chosen by their bit length, so most composites cost a few
+ * memory writes instead of an exponentiation. Numbers that are too small to be sieved are given to mpz_nextprime.
+ */
+void next_prime_sieved(mpz_t rop,mpz_t start){
+	unsigned char* composite;
+	gmp_randstate_t state;
+	mpz_t base,cand;
+	unsigned long k;
+	int rounds,found = 0;
+
+	if(mpz_cmp_ui(start,SMALL_PRIME_LIMIT) < 0){// the small primes would cross themselves out
+		mpz_nextprime(rop,start);
+		return;
+	}
+
+	composite = (unsigned char*)malloc(PRIME_SIEVE_WINDOW*sizeof(unsigned char));
+	mpz_init(base);
+	mpz_init(cand);
+	seed_prime_randstate(state);
+
+	mpz_add_ui(base,start,1);
+	mpz_setbit(base,0); /// first odd number greater than start
+	rounds = miller_rabin_rounds(mpz_sizeinbase(base,BINARY));
+
+	while(!found){
+		sieve_prime_window(composite,base);
+		for(k = 0; k < PRIME_SIEVE_WINDOW; k++){
+			if(composite[k])
+				continue;
+			mpz_add_ui(cand,base,2*k);
+			if(miller_rabin(cand,rounds,state)){
+				mpz_set(rop,cand);
+				found = 1;
+				break;
+			}
+		}
+		mpz_add_ui(base,base,2*PRIME_SIEVE_WINDOW);
+	}
+
+	gmp_randclear(state);
+	mpz_clear(base);
+	mpz_clear(cand);
+	free(composite);
+}
+/**
+ *
+ * @param arg The search
+ * @return NULL
+ *
+ * @brief Worker of the parallel prime search.
+ *
+ * Takes the next window index, sieves the window and tests its candidates, until a prime is found by any thread.
+ * The windows of the workers are disjoint, so they never test the same candidate.
+ */
+void* prime_search_worker(void* arg){
+	prime_search* ps = (prime_search*)arg;
+	unsigned char* composite = (unsigned char*)malloc(PRIME_SIEVE_WINDOW*sizeof(unsigned char));
+	gmp_randstate_t state;
+	unsigned long w,k;
+	mpz_t base,cand;
+
+	mpz_init(base);
+	mpz_init(cand);
+	seed_prime_randstate(state);
+
+	while(!__atomic_load_n(&ps->found,__ATOMIC_ACQUIRE)){
+		pthread_mutex_lock(&ps->lock);
+		w = ps->next++;
+		pthread_mutex_unlock(&ps->lock);
+
+		mpz_set_ui(base,w);
+		mpz_mul_ui(base,base,2*PRIME_SIEVE_WINDOW);
+		mpz_add(base,base,ps->start);
+		sieve_prime_window(composite,base);
+
+		for(k = 0; k < PRIME_SIEVE_WINDOW && !__atomic_load_n(&ps->found,__ATOMIC_RELAXED); k++){
+			if(composite[k])
+				continue;
+			mpz_add_ui(cand,base,2*k);
+			if(miller_rabin(cand,ps->rounds,state)){
+				pthread_mutex_lock(&ps->lock);
+				if(!ps->found){// the first winner cancels the rest
+					mpz_set(ps->result,cand);
+					__atomic_store_n(&ps->found,1,__ATOMIC_RELEASE);
+				}
+				pthread_mutex_unlock(&ps->lock);
+			}
+		}
+	}
+
+	gmp_randclear(state);
+	mpz_clear(base);
+	mpz_clear(cand);
+	free(composite);
+	return NULL;
+}
+/**
+ *
+ * @param rop The prime
+ * @param start The prime is greater than this number
+ * @param threads Number of threads
+ *
+ * @brief Finds a probable prime greater than the given number with several threads.
+ *
+ * Each thread sieves and tests its own windows of candidates after start, and the search stops at the first prime found
+ * by any of them. With more than one thread it is not always the first prime after start, but it is a prime from the
+ * first few windows after it. With one thread it is the same with next_prime_sieved.
+ */
+void next_prime_parallel(mpz_t rop,mpz_t start,int threads){
+	pthread_t tids[PRIME_SEARCH_MAX_THREADS];
+	prime_search ps;
+	int t;
+
+	if(threads <= 1 || mpz_cmp_ui(start,SMALL_PRIME_LIMIT) < 0){
+		next_prime_sieved(rop,start);
+		return;
+	}
+	if(threads > PRIME_SEARCH_MAX_THREADS)
+		threads = PRIME_SEARCH_MAX_THREADS;
+
+	mpz_init(ps.start);
+	mpz_init(ps.result);
+	mpz_add_ui(ps.start,start,1);
+	mpz_setbit(ps.start,0); /// first odd number greater than start
+	ps.rounds = miller_rabin_rounds(mpz_sizeinbase(ps.start,BINARY));
+	ps.next = 0;
+	ps.found = 0;
+	pthread_mutex_init(&ps.lock,NULL);
+
+	for(t = 0; t < threads; t++){
+		if(pthread_create(&tids[t],NULL,prime_search_worker,&ps) != 0){
+			fprintf(stderr,"pthread_create failed (next_prime_parallel)\n");
+			exit(0);
+		}
+	}
+	for(t = 0; t < threads; t++)
+		pthread_join(tids[t],NULL);
+
+	mpz_set(rop,ps.result);
+	pthread_mutex_destroy(&ps.lock);
+	mpz_clear(ps.start);
+	mpz_clear(ps.result);
+}
+/**
+ *
+ * @param rop The prime
+ * @param bits Bit length of the prime
+ * @param src Random source for the start of the search
+ *
+ * @brief Finds a random prime p = 3 mod 4 with exactly the given bit length.
+ */
+void find_blum_prime(mpz_t rop,int bits,rand_source* src){
+	mpz_t start;
+
+	mpz_init(start);
+	do {
+		rand_mpz_bits(src,start,bits);
+		mpz_setbit(start,bits-1);
+		mpz_setbit(start,bits-2);
+		next_prime_sieved(rop,start);
+		while(mpz_fdiv_ui(rop,4) != 3)
+			next_prime_sieved(rop,rop);
+	}while(mpz_sizeinbase(rop,BINARY) != (size_t)bits);
+	mpz_clear(start);
+}
+/**
+ *
+ * @param modulus_bits Bit length of the modulus
+ * @param src Random source for the primes and the seed
+ * @return A seeded Blum Blum Shub engine
+ *
+ * @brief Creates a Blum Blum Shub engine with a new Blum integer modulus.
+ *
+ * The seed s is random and coprime to n, the first state is s^2 mod n. The primes are not kept.
+ */
+bbs_engine* create_bbs_engine(int modulus_bits,rand_source* src){
+	bbs_engine* eng = (bbs_engine*)malloc(sizeof(bbs_engine));
+	mpz_t p,q,g;
+
+	mpz_init(p);
+	mpz_init(q);
+	mpz_init(g);
+	mpz_init(eng->n);
+	mpz_init(eng->x);
+
+	do {
+		find_blum_prime(p,modulus_bits/2,src);
+		find_blum_prime(q,modulus_bits - modulus_bits/2,src);
+	}while(mpz_cmp(p,q) == 0);
+	mpz_mul(eng->n,p,q);
+
+	do {// seed coprime to n, not 0 or 1
+		rand_mpz_bits(src,eng->x,modulus_bits);
+		mpz_mod(eng->x,eng->x,eng->n);
+		mpz_gcd(g,eng->x,eng->n);
+	}while(mpz_cmp_ui(eng->x,1) <= 0 || mpz_cmp_ui(g,1) != 0);
+	mpz_mul(eng->x,eng->x,eng->x);
+	mpz_mod(eng->x,eng->x,eng->n);
+
+	// log2(log2 n) bits for each squaring
+	eng->step_bits = 0;
+	while(((size_t)2 << eng->step_bits) <= mpz_sizeinbase(eng->n,BINARY))
+		eng->step_bits++;
+	eng->acc = 0;
+	eng->acc_bits = 0;
+
+	mpz_clear(p);
+	mpz_clear(q);
+	mpz_clear(g);
+	return eng;
+}
+/**
+ *
+ * @param eng The engine
+ *
+ * @brief Frees the engine, its state is cleared first.
+ */
+void free_bbs_engine(bbs_engine* eng){
+	mpz_set_ui(eng->x,0);
+	mpz_clear(eng->n);
+	mpz_clear(eng->x);
+	eng->acc = 0;
+	free(eng);
+}
+/**
+ *
+ * @param eng The engine
+ * @param out Output words
+ * @param nwords Number of 64 bit words
+ *
+ * @brief Fills the words with the bits of the engine.
+ *
+ * Each squaring adds step_bits bits to the accumulator, a word is written when 64 bits are collected. The bits that
+ * do not fit into the word stay in the accumulator for the next one, so no bits are thrown away between calls.
+ */
+void bbs_engine_fill_words(bbs_engine* eng,uint64_t* out,size_t nwords){
+	uint64_t mask = ((uint64_t)1 << eng->step_bits) - 1;
+	uint64_t bits,word;
+	size_t i;
+	int filled;
+
+	for(i = 0; i < nwords; i++){
+		word = eng->acc;
+		filled = eng->acc_bits;
+		while(1){
+			mpz_mul(eng->x,eng->x,eng->x);
+			mpz_mod(eng->x,eng->x,eng->n); /// x = x^2 mod n
+			bits = mpz_getlimbn(eng->x,0) & mask;
+			if(filled + eng->step_bits >= 64){
+				word |= bits << filled;
+				// the rest of the bits go to the accumulator
+				eng->acc_bits = filled + eng->step_bits - 64;
+				eng->acc = eng->acc_bits > 0 ? bits >> (eng->step_bits - eng->acc_bits) : 0;
+				break;
+			}
+			word |= bits << filled;
+			filled += eng->step_bits;
+		}
+		out[i] = word;
+	}
+}
+/**
+ *
+ * @param src The source
+ * @param buf Output buffer
+ * @param len Number of bytes
+ *
+ * @brief Fill function of the Blum Blum Shub source.
+ */
+void bbs_rand_fill(rand_source* src,unsigned char* buf,size_t len){
+	uint64_t words[64];
+	size_t n;
+
+	while(len > 0){
+		n = len < sizeof(words) ? len : sizeof(words);
+		bbs_engine_fill_words((bbs_engine*)src->state,words,(n + 7) / 8);
+		memcpy(buf,words,n);
+		buf += n;
+		len -= n;
+	}
+	memset(words,0,sizeof(words));
+}
+/**
+ *
+ * @param src The source
+ *
+ * @brief Frees the Blum Blum Shub source and its engine.
+ */
+void bbs_rand_destroy(rand_source* src){
+	free_bbs_engine((bbs_engine*)src->state);
+	free(src);
+}
+/**
+ *
+ * @param modulus_bits Bit length of the modulus
+ * @return A random source backed by a new Blum Blum Shub engine
+ *
+ * @brief Creates a Blum Blum Shub random source, its modulus is generated from the thread's DRBG.
+ *
+ * It is much slower than the DRBG, it is meant for the workflows that require Blum Blum Shub.
+ */
+rand_source* create_bbs_rand_source(int modulus_bits){
+	rand_source* src = (rand_source*)malloc(sizeof(rand_source));
+
+	src->fill = bbs_rand_fill;
+	src->destroy = bbs_rand_destroy;
+	src->state = create_bbs_engine(modulus_bits,get_thread_rand_source());
+	return src;
+}
+/**
+ *
+ * @param src Random source
+ * @param bit_length Bit length for the random number.
+ * @param threads Number of threads searching for the prime
+ * @return Prime random number with desired bit length.
+ *
+ * @brief Generates random prime numbers from the given random source.
+ *
+ * The start of the search is read from the source directly into the limbs. Its two top bits are set,
+ * so the prime has exactly bit_length bits and the product of two such primes has exactly 2 x bit_length bits.
+ */
+mpz_t* create_random_prime_gmp_number_from_source(rand_source* src,int bit_length,int threads){
+	mpz_t* num = (mpz_t*)malloc(sizeof(mpz_t));
+
+	mpz_init(*num);
+	rand_mpz_bits(src,*num,bit_length);
+	mpz_setbit(*num,bit_length-1);
+	mpz_setbit(*num,bit_length-2);
+	next_prime_parallel(*num,*num,threads); //find a prime number greater than the random number
+
+	return num;
+}
+/**
+ *
+ * @param bit_length Bit length for the random number.
+ * @param threads Number of threads searching for the prime
+ * @return Prime random number with desired bit length.
+ *
+ * @brief Generates random prime numbers from the thread's ChaCha20 DRBG.
+ */
+mpz_t* create_random_prime_gmp_number_threads(int bit_length,int threads){
+	return create_random_prime_gmp_number_from_source(get_thread_rand_source(),bit_length,threads);
+}
+/**
+ *
+ * @param bit_length Bit length for the random number.
+ * @param threads Number of threads searching for the prime
+ * @return Prime random number with desired bit length.
+ *
+ * @brief Generates random prime numbers with bbs algorithm.
+ *
+ * The function computes a random number with blum blum shub with desired bit length and
+ * primerize the number. The return value is a GMP number. A new engine with a BBS_MODULUS_BITS modulus is
+ * created for the call, keep a source from create_bbs_rand_source to generate more primes.
+ */
+mpz_t* create_random_prime_gmp_number_with_bbs_threads(int bit_length,int threads){
+	rand_source* src = create_bbs_rand_source(BBS_MODULUS_BITS);
+	mpz_t* num = create_random_prime_gmp_number_from_source(src,bit_length,threads);
+
+	src->destroy(src);
+	return num;
+}
+/**
+ *
+ * @param bit_length Bit length for the random number.
+ * @return Prime random number with desired bit length.
+ *
+ * @brief Generates random prime numbers with bbs algorithm on the calling thread.
+ */
+mpz_t* create_random_prime_gmp_number_with_bbs(int bit_length){
+	return create_random_prime_gmp_number_with_bbs_threads(bit_length,1);
+}
+/**
+ *
+ * @param bits Bit length of the exponent
+ * @return Window size in bits
+ *
+ * @brief Picks the sliding window size for an exponent.
+ *
+ * Bigger windows mean less multiplications but a bigger precomputed table of odd powers (2^(window-1) entries),
+ * so the window size grows with the bit length of the exponent.
+ */
+int exp_window_size(size_t bits){
+	if(bits > 671)
+		return 6;
+	if(bits > 239)
+		return 5;
+	if(bits > 79)
+		return 4;
+	if(bits > 23)
+		return 3;
+	if(bits > 7)
+		return 2;
+	return 1;
+}
+/**
+ *
+ * @param limbs Limbs of the number
+ * @param i Index of the lowest bit
+ * @param len Number of bits to read (at most GMP_NUMB_BITS)
+ * @return The bits i..i+len-1 of the number
+ *
+ * @brief Reads a bit field directly from the limbs of a GMP number.
+ */
+unsigned int get_bits_of_limbs(const mp_limb_t* limbs, size_t i, int len){
+	size_t limb = i / GMP_NUMB_BITS;
+	int shift = i % GMP_NUMB_BITS;
+	mp_limb_t bits = limbs[limb] >> shift;
+
+	if(shift + len > GMP_NUMB_BITS)// the field continues in the next limb
+		bits |= limbs[limb+1] << (GMP_NUMB_BITS - shift);
+
+	return (unsigned int)(bits & ((((mp_limb_t)1) << len) - 1));
+}
+/**
+ *
+ * @param power The exponent
+ * @return The exponent recoded into sliding windows.
+ *
+ * @brief Recodes the exponent into sliding windows.
+ *
+ * The exponent is scanned from the most significant bit to the least significant bit directly on its limbs.
+ * Zero bits are collected as squarings and every run of at most window bits that ends with a one bit becomes a window.
+ * The window size is chosen from the bit length of the exponent.
+ */
+exp_windows* recode_exponent(mpz_t power){
+	exp_windows* w = (exp_windows*)malloc(sizeof(exp_windows));
+	const mp_limb_t* limbs = mpz_limbs_read(power);
+	size_t bits = mpz_sgn(power) == 0 ? 0 : mpz_sizeinbase(power,BINARY);
+	size_t pending = 0; // squarings waiting for the next window
+	size_t i,j;
+	int len;
+
+	w->window = exp_window_size(bits);
+	w->count = 0;
+	w->tail = 0;
+	// there can be at most one window per bit
+	w->value = (unsigned int*)malloc((bits+1)*sizeof(unsigned int));
+	w->squares = (size_t*)malloc((bits+1)*sizeof(size_t));
+
+	i = bits;
+	while(i > 0){
+		if(!get_bits_of_limbs(limbs,i-1,1)){// zero bit, only a squaring
+			pending++;
+			i--;
+			continue;
+		}
+		// take at most window bits and move the lowest bit of the window to a one bit
+		j = i > (size_t)w->window ? i - w->window : 0;
+		while(!get_bits_of_limbs(limbs,j,1))
+			j++;
+		len = i - j;
+
+		w->value[w->count] = get_bits_of_limbs(limbs,j,len);
+		w->squares[w->count] = w->count == 0 ? 0 : pending + len;
+		w->count++;
+		pending = 0;
+		i = j;
+	}
+	w->tail = pending;
+
+	return w;
+}
+/**
+ *
+ * @param w Recoded exponent
+ *
+ * @brief Frees the recoded exponent.
+ */
+void free_exp_windows(exp_windows* w){
+	free(w->value);
+	free(w->squares);
+	free(w);
+}
+/**
+ *
+ * @param rop Result of the multiplication
+ * @param a First factor
+ * @param b Second factor
+ * @param mod Modulo number
+ * @param temp Temporary number for the double size product
+ *
+ * @brief Multiplies two numbers and reduces the product, rop = a x b mod mod.
+ *
+ * The product is written to a preallocated temporary so no memory is allocated in the exponentiation loop.
+ */
+void mul_mod(mpz_t rop, mpz_t a, mpz_t b, mpz_t mod, mpz_t temp){
+	mpz_mul(temp,a,b);
+	mpz_tdiv_r(rop,temp,mod);
+}
+/**
+ *
+ * @param f The result
+ * @param base Base number
+ * @param w Recoded exponent
+ * @param mod Modulo number
+ *
+ * @brief Does the sliding window exponentiation f = base^power mod mod with a recoded exponent.
+ *
+ * The odd powers base^1, base^3, ..., base^(2^window - 1) are computed first. Then for each window the result is squared
+ * and multiplied once with the power of the window's value.
+ */
+void exp_with_windows(mpz_t f, mpz_t base, exp_windows* w, mpz_t mod){
+	mpz_t table[1 << (EXP_MAX_WINDOW-1)]; // odd powers of base
+	mpz_t b2,temp;
+	int table_size = 1 << (w->window - 1);
+	size_t mod_bits = mpz_sizeinbase(mod,BINARY);
+	size_t i,k;
+	int t;
+
+	if(w->count == 0){// power is 0
+		mpz_set_ui(f,1);
+		mpz_mod(f,f,mod);
+		return;
+	}
+
+	mpz_init2(temp,2*mod_bits);
+	mpz_init2(b2,mod_bits);
+
+	// table[t] = base^(2t+1) mod mod
+	mpz_init2(table[0],mod_bits);
+	mpz_mod(table[0],base,mod);
+	if(table_size > 1)
+		mul_mod(b2,table[0],table[0],mod,temp); // b2 = base^2
+	for(t = 1; t < table_size; t++){
+		mpz_init2(table[t],mod_bits);
+		mul_mod(table[t],table[t-1],b2,mod,temp);
+	}
+
+	mpz_set(f,table[w->value[0] >> 1]);
+	for(i = 1; i < w->count; i++){
+		for(k = 0; k < w->squares[i]; k++)
+			mul_mod(f,f,f,mod,temp); // f = f^2
+		mul_mod(f,f,table[w->value[i] >> 1],mod,temp); // f = f x base^value
+	}
+	for(k = 0; k < w->tail; k++)
+		mul_mod(f,f,f,mod,temp);
+
+	for(t = 0; t < table_size; t++)
+		mpz_clear(table[t]);
+	mpz_clear(b2);
+	mpz_clear(temp);
+}
+/**
+ *
+ * @param n Modulo number
+ * @return Montgomery constants for n, NULL if n is even.
+ *
+ * @brief Computes the Montgomery constants n' and R^2 mod n of the modulo number.
+ *
+ * The constants only depend on the modulo number, so they are computed once and used for all exponentiations with that modulo.
+ */
+mont_ctx* create_mont_ctx(mpz_t n){
+	mont_ctx* ctx;
+	mpz_t temp,b;
+	mp_size_t i;
+
+	if(mpz_even_p(n) || mpz_cmp_ui(n,1) <= 0)// Montgomery reduction needs an odd modulo number
+		return NULL;
+
+	ctx = (mont_ctx*)malloc(sizeof(mont_ctx));
+	mpz_init_set(ctx->n,n);
+	ctx->size = mpz_size(n);
+	ctx->r2 = (mp_limb_t*)malloc(ctx->size*sizeof(mp_limb_t));
+	ctx->mapped = 0;
+
+	mpz_init(temp);
+	mpz_init(b);
+
+	// n' = -n^-1 mod B where B = 2^GMP_NUMB_BITS
+	mpz_setbit(b,GMP_NUMB_BITS);
+	mpz_set_ui(temp,0);
+	mpz_limbs_write(temp,1)[0] = mpz_getlimbn(n,0);
+	mpz_limbs_finish(temp,1);
+	mpz_invert(temp,temp,b);
+	mpz_sub(temp,b,temp);
+	ctx->ninv = mpz_getlimbn(temp,0);
+
+	// R^2 mod n
+	mpz_set_ui(temp,0);
+	mpz_setbit(temp,2*ctx->size*GMP_NUMB_BITS);
+	mpz_mod(temp,temp,n);
+	for(i = 0; i < ctx->size; i++)
+		ctx->r2[i] = mpz_getlimbn(temp,i);
+
+	mpz_clear(temp);
+	mpz_clear(b);
+	return ctx;
+}
+/**
+ *
+ * @param ctx Montgomery constants
+ *
+ * @brief Frees the Montgomery constants.
+ */
+void free_mont_ctx(mont_ctx* ctx){
+	if(ctx == NULL)
+		return;
+	if(!ctx->mapped){
+		mpz_clear(ctx->n);
+		free(ctx->r2);
+	}
+	free(ctx);
+}
+/**
+ *
+ * @param rp Result, size limbs
+ * @param tp Number to reduce, 2 x size limbs, it is destroyed
+ * @param ctx Montgomery constants
+ *
+ * @brief Montgomery reduction, rp = tp x R^-1 mod n.
+ *
+ * Each step adds a multiple of n which clears the lowest limb. The carry of the step is kept in the cleared limb
+ * and all carries are added at once at the end.
+ */
+void mont_redc(mp_limb_t* rp, mp_limb_t* tp, mont_ctx* ctx){
+	const mp_limb_t* np = mpz_limbs_read(ctx->n);
+	mp_size_t k = ctx->size;
+	mp_size_t i;
+	mp_limb_t cy;
+
+	for(i = 0; i < k; i++){
+		tp[i] = mpn_addmul_1(tp+i,np,k,tp[i]*ctx->ninv);
+	}
+	cy = mpn_add_n(rp,tp+k,tp,k);
+	if(cy || mpn_cmp(rp,np,k) >= 0)
+		mpn_sub_n(rp,rp,np,k);
+}
+/**
+ *
+ * @param rp Result, size limbs
+ * @param ap First factor, size limbs
+ * @param bp Second factor, size limbs
+ * @param tp Temporary space, 2 x size limbs
+ * @param ctx Montgomery constants
+ *
+ * @brief Montgomery multiplication, rp = ap x bp x R^-1 mod n.
+ *
+ * The product is reduced right after the multiplication. Squarings use the faster squaring function of GMP.
+ */
+void mont_mul(mp_limb_t* rp, const mp_limb_t* ap, const mp_limb_t* bp, mp_limb_t* tp, mont_ctx* ctx){
+	if(ap == bp)
+		mpn_sqr(tp,ap,ctx->size);
+	else
+		mpn_mul_n(tp,ap,bp,ctx->size);
+	mont_redc(rp,tp,ctx);
+}
+/**
+ *
+ * @param rp Output, base mod n as size limbs
+ * @param base Base number
+ * @param ctx Montgomery constants of the modulo number
+ * @param scratch Arena of the quotient limbs, they are freed by the caller
+ *
+ * @brief Reduces the base with the limb division of GMP, without a GMP number for the remainder.
+ */
+void mont_reduce_base(mp_limb_t* rp, mpz_t base, mont_ctx* ctx, arena* scratch){
+	mp_size_t k = ctx->size;
+	mp_size_t bn = mpz_size(base);
+	mp_limb_t* qp;
+
+	mpn_zero(rp,k);
+	if(bn < k){// already below n, the top limb of n is not zero
+		if(bn > 0)
+			mpn_copyi(rp,mpz_limbs_read(base),bn);
+	}
+	else{
+		qp = (mp_limb_t*)arena_alloc(scratch,(bn-k+1)*sizeof(mp_limb_t));
+		mpn_tdiv_qr(qp,rp,0,mpz_limbs_read(base),bn,mpz_limbs_read(ctx->n),k);
+	}
+	if(mpz_sgn(base) < 0 && !mpn_zero_p(rp,k))// the remainder of |base|, it is taken from n like mpz_mod does
+		mpn_sub_n(rp,mpz_limbs_read(ctx->n),rp,k);
+}
+/**
+ *
+ * @param f The result
+ * @param base Base number
+ * @param w Recoded exponent
+ * @param ctx Montgomery constants of the modulo number
+ *
+ * @brief Does the sliding window exponentiation f = base^power mod n in the Montgomery form.
+ *
+ * It is the same algorithm with exp_with_windows, but the numbers are kept in the Montgomery form so every
+ * multiplication is followed by a Montgomery reduction instead of a division. All the temporary space is taken from
+ * the thread's arena once and freed at the end.
+ */
+void exp_with_windows_mont(mpz_t f, mpz_t base, exp_windows* w, mont_ctx* ctx){
+	mp_size_t k = ctx->size;
+	int table_size = 1 << (w->window - 1);
+	arena* scratch = get_thread_arena();
+	arena_mark mark;
+	mp_limb_t *table,*tp,*fp,*b2;
+	size_t i,j;
+	int t;
+
+	if(w->count == 0){// power is 0
+		mpz_set_ui(f,1);
+		return;
+	}
+
+	// table has table_size entries, tp 2k limbs, fp and b2 k limbs
+	mark = arena_save(scratch);
+	table = (mp_limb_t*)arena_alloc(scratch,(table_size*k + 4*k)*sizeof(mp_limb_t));
+	tp = table + table_size*k;
+	fp = tp + 2*k;
+	b2 = fp + k;
+
+	mont_reduce_base(fp,base,ctx,scratch); // base mod n padded to k limbs
+
+	// table[t] = base^(2t+1) x R mod n
+	mont_mul(table,fp,ctx->r2,tp,ctx);
+	if(table_size > 1)
+		mont_mul(b2,table,table,tp,ctx);
+	for(t = 1; t < table_size; t++)
+		mont_mul(table + t*k,table + (t-1)*k,b2,tp,ctx);
+
+	mpn_copyi(fp,table + (w->value[0] >> 1)*k,k);
+	for(i = 1; i < w->count; i++){
+		for(j = 0; j < w->squares[i]; j++)
+			mont_mul(fp,fp,fp,tp,ctx); // f = f^2
+		mont_mul(fp,fp,table + (w->value[i] >> 1)*k,tp,ctx); // f = f x base^value
+	}
+	for(j = 0; j < w->tail; j++)
+		mont_mul(fp,fp,fp,tp,ctx);
+
+	// convert back from the Montgomery form
+	mpn_copyi(tp,fp,k);
+	mpn_zero(tp+k,k);
+	mont_redc(fp,tp,ctx);
+	mpn_copyi(mpz_limbs_write(f,k),fp,k);
+	mpz_limbs_finish(f,k);
+
+	arena_restore(scratch,mark);
+}
+/**
+ *
+ * @param f The result
+ * @param base Base number
+ * @param power Power of the number, a short exponent like 65537
+ * @param ctx Montgomery constants of the modulo number
+ *
+ * @brief Does the exponentiation f = base^power mod n for a short exponent in the Montgomery form.
+ *
+ * Short public exponents have very few bits set, so plain left to right square and multiply is used without the
+ * window table of exp_with_windows_mont. For 65537 it is 16 squarings and 1 multiplication, plus the conversions.
+ */
+void exp_short_mont(mpz_t f, mpz_t base, unsigned long power, mont_ctx* ctx){
+	mp_size_t k = ctx->size;
+	arena* scratch = get_thread_arena();
+	arena_mark mark;
+	mp_limb_t *tp,*fp,*ap;
+	int i;
+
+	if(power == 0){
+		mpz_set_ui(f,1);
+		return;
+	}
+
+	mark = arena_save(scratch);
+	tp = (mp_limb_t*)arena_alloc(scratch,4*k*sizeof(mp_limb_t));
+	fp = tp + 2*k;
+	ap = fp + k;
+
+	mont_reduce_base(fp,base,ctx,scratch); // base mod n padded to k limbs
+
+	mont_mul(ap,fp,ctx->r2,tp,ctx); // base x R mod n
+	mpn_copyi(fp,ap,k);
+	for(i = (int)(8*sizeof(unsigned long)) - 2 - __builtin_clzl(power); i >= 0; i--){// bits below the top bit
+		mont_mul(fp,fp,fp,tp,ctx); // f = f^2
+		if((power >> i) & 1)
+			mont_mul(fp,fp,ap,tp,ctx); // f = f x base
+	}
+
+	// convert back from the Montgomery form
+	mpn_copyi(tp,fp,k);
+	mpn_zero(tp+k,k);
+	mont_redc(fp,tp,ctx);
+	mpn_copyi(mpz_limbs_write(f,k),fp,k);
+	mpz_limbs_finish(f,k);
+
+	arena_restore(scratch,mark);
+}
+/**
+ *
+ * @param f The remaining.
+ * @param base Base number
+ * @param power Power of the number
+ * @param mod Modulo number
+ *
+ * @brief Does exponentiation for the encryption process to the very large numbers.
+ *
+ * The function implemented with GMP functions for working easily with big numbers. The exponent is read directly from its
+ * limbs and recoded into sliding windows whose size depends on the bit length of the exponent, so for a 1024 bit exponent
+ * there are 1024 squarings but only about 1024/6 multiplications. For odd modulo numbers the exponentiation is done in
+ * the Montgomery form. The exponent recoding and the Montgomery constants are computed for each call here, use rsa_key_ctx
+ * to keep them for all the blocks of a key.
+ */
+void take_mod_of_exp_number2(mpz_t f, mpz_t base, mpz_t power, mpz_t mod){
+	exp_windows* w = recode_exponent(power);
+	mont_ctx* ctx = create_mont_ctx(mod);
+
+	if(ctx != NULL)
+		exp_with_windows_mont(f,base,w,ctx);
+	else // even modulo number, no Montgomery form
+		exp_with_windows(f,base,w,mod);
+
+	free_mont_ctx(ctx);
+	free_exp_windows(w);
+}
+/**
+ *
+ * @param out Output buffer
+ * @param width Number of bytes to write
+ * @param v Number to write, it has to fit into width bytes
+ *
+ * @brief Writes the number as a big endian number of exactly width bytes.
+ *
+ * mpz_export leaves out the leading zero bytes, they are put here so the number always takes width bytes.
+ */
+void export_fixed(unsigned char* out, size_t width, mpz_t v){
+	size_t bytes = mpz_sgn(v) == 0 ? 0 : (mpz_sizeinbase(v,BINARY) + 7) / 8;
+
+	memset(out,0,width - bytes);
+	if(bytes > 0)
+		mpz_export(out + width - bytes,NULL,1,1,1,0,v);
+}
+/**
+ *
+ * @param rop Generated random number
+ * @param mod Defines the max value for the random number
+ * @param seed Seed for the random number
+ *
+ * @brief Generates a random number with GMP Library functions.
+ *
+ * The function generates a random number by using GMP random number functions.
+ */
+void generate_gmp_rand_num(mpz_t rop,mpz_t mod,unsigned long int seed){
+	//mpz_t* rand_Num = (mpz_t*)malloc(sizeof(mpz_t));
+
+	if(seed == 0)//if seed is not specified by the user
+		seed = time(NULL);
+
+	gmp_randstate_t r_state;
+
+	gmp_randinit_default (r_state);
+	gmp_randseed_ui(r_state, seed);
+
+	mpz_urandomm(rop,r_state,mod);
+
+	gmp_randclear(r_state);
+}
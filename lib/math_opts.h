@@ -2,7 +2,7 @@
  * @file
  * @brief Header containing number generators.
  *
- * The header file contains the random number generator and primerizing functions.
+ * The header file declares the random number generator and primerizing functions.
  * The random numbers generators work with blum blum shub and GMP library functions.
  */
 
@@ -12,35 +12,80 @@
 #include <gmp.h>
 #include <time.h>
 #include <string.h>
-#include "blumblumshub.h"
+#include <errno.h>
+#include <sys/random.h>
+#include <pthread.h>
+#include <stdint.h>
 #include "bit_opts.h"
+#include "small_primes.h"
+#include "rand_source.h"
+#include "arena.h"
 
 #define BINARY 2
 #define DECIMAL 10
+
 /**
- *
- * @param bit_length Bit length for the random number.
- * @return Prime random number with desired bit length.
- *
- * @brief Generates random prime numbers with bbs algorithm.
- *
- * The function computes a random number with blum blum shub with desired bit length and
- * primerize the number. The return value is a GMP number.
+ * Number of odd candidates sieved together by next_prime_sieved.
  */
-mpz_t* create_random_prime_gmp_number_with_bbs(int bit_length){
-	mpz_t* num = (mpz_t*)malloc(sizeof(mpz_t));
-	char* random_bitstring;
+#define PRIME_SIEVE_WINDOW 4096
 
-	random_bitstring = bbs_bit_string(bit_length,BINARY);//default 512 bit
+int miller_rabin_rounds(size_t bits);
+int miller_rabin(mpz_t n,int rounds,gmp_randstate_t state);
+void sieve_prime_window(unsigned char* composite,mpz_t base);
+void seed_prime_randstate(gmp_randstate_t state);
+void next_prime_sieved(mpz_t rop,mpz_t start);
 
-	mpz_init(*num);
-	mpz_init_set_str(*num,random_bitstring,BINARY);//initialize to our
-	mpz_nextprime(*num,*num); //find the next prime number greater than our random number
+/**
+ * Upper limit for the number of threads of a parallel prime search.
+ */
+#define PRIME_SEARCH_MAX_THREADS 256
 
-	free(random_bitstring);//free char buffer
+/**
+ * @struct PRIME_SEARCH
+ * @brief PRIME_SEARCH is the state shared by the threads searching for the same prime.
+ */
+typedef struct PRIME_SEARCH {
+	mpz_t start; // first odd candidate of window 0
+	int rounds; // Miller-Rabin rounds for the candidates
+	pthread_mutex_t lock; // protects next and the result
+	unsigned long next; // index of the next window that is not taken yet
+	int found; // set under the lock by the first thread that finds a prime, the others stop, read with __atomic_load_n
+	mpz_t result; // the prime
+}prime_search;
+
+void* prime_search_worker(void* arg);
+void next_prime_parallel(mpz_t rop,mpz_t start,int threads);
+/**
+ * Default bit length of the modulus of the Blum Blum Shub engine.
+ */
+#define BBS_MODULUS_BITS 2048
 
-	return num;
-}
+/**
+ * @struct BBS_ENGINE
+ * @brief BBS_ENGINE is the state of a Blum Blum Shub generator with a large modulus.
+ *
+ * The modulus is a Blum integer n = p x q with p = q = 3 mod 4. Each squaring x = x^2 mod n gives the lowest
+ * log2(log2 n) bits of x, which are collected in a 64 bit word until it is full.
+ */
+typedef struct BBS_ENGINE {
+	mpz_t n; // Blum integer modulus
+	mpz_t x; // current state
+	int step_bits; // bits taken from each square, log2(log2 n)
+	uint64_t acc; // bits taken but not given out yet
+	int acc_bits; // number of bits in acc
+}bbs_engine;
+
+void find_blum_prime(mpz_t rop,int bits,rand_source* src);
+bbs_engine* create_bbs_engine(int modulus_bits,rand_source* src);
+void free_bbs_engine(bbs_engine* eng);
+void bbs_engine_fill_words(bbs_engine* eng,uint64_t* out,size_t nwords);
+void bbs_rand_fill(rand_source* src,unsigned char* buf,size_t len);
+void bbs_rand_destroy(rand_source* src);
+rand_source* create_bbs_rand_source(int modulus_bits);
+mpz_t* create_random_prime_gmp_number_from_source(rand_source* src,int bit_length,int threads);
+mpz_t* create_random_prime_gmp_number_threads(int bit_length,int threads);
+mpz_t* create_random_prime_gmp_number_with_bbs_threads(int bit_length,int threads);
+mpz_t* create_random_prime_gmp_number_with_bbs(int bit_length);
 
 //mpz_t* take_mod_of_exp_number(mpz_t* base, mpz_t* power, mpz_t* mod){
 //	mpz_t* f = (mpz_t*)malloc(sizeof(mpz_t));
@@ -85,83 +130,55 @@ mpz_t* create_random_prime_gmp_number_with_bbs(int bit_length){
 //}
 
 /**
- *
- * @param f The remaining.
- * @param base Base number
- * @param power Power of the number
- * @param mod Modulo number
- *
- * @brief Does exponentiation for the encryption process to the very large numbers.
- *
- * The function implemented with GMP functions for working easily with big numbers. It does modulo operation to
- * exponential functions quickly. Since the for loop inside the function loops for the bit length of the exponential number,
- * the function runs very fast. For example if we have 1024 bit key and we are doing the encryption, the loop only loops for 1024 times.
- * It turns out O(n) is the run time for the whole encryption.
+ * Largest window size used by the sliding window exponentiation.
  */
-void take_mod_of_exp_number2(mpz_t f, mpz_t base, mpz_t power, mpz_t mod){
-	//mpz_t* f = (mpz_t*)malloc(sizeof(mpz_t));
-	mpz_t c,ftemp;
-	int i,size;
-	char* bits_of_num;
-
-	//initialize
-	//mpz_init(c);
-	//mpz_init(*f);
-	mpz_init(ftemp);
-	mpz_init_set_ui(c,0); // c = 0
-	mpz_init_set_ui(f,1); // f = 1
-
-	//convert base to bits
-	bits_of_num = mpz_get_str(NULL,BINARY,power);
-	if(bits_of_num == NULL){
-		printf("mpz_get_str returned NULL pointer in the take_mod_of_exp_number function");
-		exit(0);
-	}
-	//find the bit length
-	size = mpz_sizeinbase(power,BINARY);
-
-	//do the loop
-	for(i = 0; i < size; i++){
-		mpz_mul_ui(c,c,2); // c<-(cx2)
-		mpz_pow_ui(ftemp,f,2); // ftemp = f^2
-		mpz_mod(f,ftemp,mod); // take ftemp(f x f) mod n
-		if(bits_of_num[i] == '1'){
-			mpz_add_ui(c,c,1); // c<-c+1
-			mpz_mul(ftemp,base,f); // ftemp = f x base
-			mpz_mod(f,ftemp,mod); // take ftemp(f x base) mod n
-		}
-	}
-
-	//free the temporarily allocated memory
-	free(bits_of_num);
-	mpz_clear(c);
-	mpz_clear(ftemp);
-}
+#define EXP_MAX_WINDOW 6
+
 /**
+ * @struct EXP_WINDOWS
+ * @brief EXP_WINDOWS holds an exponent recoded into sliding windows.
  *
- * @param rop Generated random number
- * @param mod Defines the max value for the random number
- * @param seed Seed for the random number
- *
- * @brief Generates a random number with GMP Library functions.
+ * Each window is an odd number of at most window bits. Before multiplying with base^value of a window
+ * the result is squared squares times. The first window only sets the result, its squares value is 0.
+ */
+typedef struct EXP_WINDOWS {
+	int window; // window size in bits
+	size_t count; // number of windows
+	unsigned int* value; // odd value of each window
+	size_t* squares; // squarings done before multiplying with the window's value
+	size_t tail; // squarings done after the last window
+}exp_windows;
+
+int exp_window_size(size_t bits);
+unsigned int get_bits_of_limbs(const mp_limb_t* limbs, size_t i, int len);
+exp_windows* recode_exponent(mpz_t power);
+void free_exp_windows(exp_windows* w);
+void mul_mod(mpz_t rop, mpz_t a, mpz_t b, mpz_t mod, mpz_t temp);
+void exp_with_windows(mpz_t f, mpz_t base, exp_windows* w, mpz_t mod);
+/**
+ * @struct MONT_CTX
+ * @brief MONT_CTX holds the Montgomery constants of an odd modulo number.
  *
- * The function generates a random number by using GMP random number functions.
+ * R is 2^(size x GMP_NUMB_BITS). The numbers in Montgomery form are kept as size limb arrays so the
+ * multiplications and reductions work on the limbs directly.
  */
-void generate_gmp_rand_num(mpz_t rop,mpz_t mod,unsigned long int seed){
-	//mpz_t* rand_Num = (mpz_t*)malloc(sizeof(mpz_t));
-
-	if(seed == 0)//if seed is not specified by the user
-		seed = time(NULL);
-
-	gmp_randstate_t r_state;
-
-	gmp_randinit_default (r_state);
-	gmp_randseed_ui(r_state, seed);
-
-	mpz_urandomm(rop,r_state,mod);
-
-	gmp_randclear(r_state);
-}
-
+typedef struct MONT_CTX {
+	mpz_t n; // modulo number, it has to be odd
+	mp_limb_t* r2; // R^2 mod n as size limbs
+	mp_limb_t ninv; // n' = -n^-1 mod 2^GMP_NUMB_BITS
+	mp_size_t size; // number of limbs of n
+	int mapped; // 1 if n and r2 point into a mapped key file, they are not freed
+}mont_ctx;
+
+mont_ctx* create_mont_ctx(mpz_t n);
+void free_mont_ctx(mont_ctx* ctx);
+void mont_redc(mp_limb_t* rp, mp_limb_t* tp, mont_ctx* ctx);
+void mont_mul(mp_limb_t* rp, const mp_limb_t* ap, const mp_limb_t* bp, mp_limb_t* tp, mont_ctx* ctx);
+void mont_reduce_base(mp_limb_t* rp, mpz_t base, mont_ctx* ctx, arena* scratch);
+void exp_with_windows_mont(mpz_t f, mpz_t base, exp_windows* w, mont_ctx* ctx);
+void exp_short_mont(mpz_t f, mpz_t base, unsigned long power, mont_ctx* ctx);
+void take_mod_of_exp_number2(mpz_t f, mpz_t base, mpz_t power, mpz_t mod);
+void export_fixed(unsigned char* out, size_t width, mpz_t v);
+void generate_gmp_rand_num(mpz_t rop,mpz_t mod,unsigned long int seed);
 
 #endif /* MATH_OPTS_H_ */
@@ -0,0 +1,172 @@
+/**
+ * @file
+ * @brief Merkle tree hashing and signatures.
+ */
+
+#include "merkle_opts.h"
+
+/**
+ *
+ * @param i Index of the leaf
+ * @param arg The job
+ *
+ * @brief Hashes the i'th chunk of the message, with a 0 byte in front so a leaf can not be taken for a node.
+ */
+void merkle_leaf(size_t i,void* arg){
+	merkle_job* job = (merkle_job*)arg;
+	size_t start = i*job->chunk;
+	size_t len = job->size - start < job->chunk ? job->size - start : job->chunk;
+	unsigned char prefix = 0x00;
+	sha256_context ctx;
+
+	sha256_starts(&ctx);
+	sha256_update(&ctx,&prefix,1);
+	sha256_update_buffer(&ctx,job->data+start,len);
+	sha256_finish(&ctx,job->digests+32*i);
+}
+/**
+ *
+ * @param i Index of the node
+ * @param arg The job
+ *
+ * @brief Hashes the digests of the children of the i'th node, with a 1 byte in front.
+ */
+void merkle_node(size_t i,void* arg){
+	merkle_job* job = (merkle_job*)arg;
+	size_t first = i*job->arity;
+	size_t n = job->below_count - first < job->arity ? job->below_count - first : job->arity;
+	unsigned char prefix = 0x01;
+	sha256_context ctx;
+
+	sha256_starts(&ctx);
+	sha256_update(&ctx,&prefix,1);
+	sha256_update(&ctx,(unsigned char*)job->below+32*first,32*n);
+	sha256_finish(&ctx,job->digests+32*i);
+}
+/**
+ *
+ * @param chunk Bytes in a leaf chunk
+ * @param arity Children of a node
+ * @return true(1) if a receiver builds a tree of this shape, false(0) otherwise
+ *
+ * @brief The chunk size and the arity come from the received message, so they are bounded before a tree is built.
+ */
+int is_merkle_shape_valid(size_t chunk,size_t arity){
+	return chunk >= MERKLE_MIN_CHUNK_SIZE && chunk <= MERKLE_MAX_CHUNK_SIZE && arity >= 2 && arity <= MERKLE_MAX_ARITY;
+}
+/**
+ *
+ * @param count Number of the digests
+ * @return Buffer for the digests
+ */
+static unsigned char* alloc_digests(size_t count){
+	unsigned char* digests = (unsigned char*)malloc(32*count*sizeof(unsigned char));
+
+	if(digests == NULL){
+		fprintf(stderr,"Not enough memory for the Merkle tree!\nExiting...\n");
+		exit(0);
+	}
+	return digests;
+}
+/**
+ *
+ * @param data Message
+ * @param size Size of the message
+ * @param chunk Bytes in a leaf chunk
+ * @param arity Children of a node
+ * @param root Output, 32 byte root of the tree
+ *
+ * @brief Computes the root of the Merkle tree of the message on the worker threads of the block engine.
+ *
+ * An empty message has a single empty leaf. A tree with a single leaf has that leaf as its root. The counts are
+ * rounded up without adding to the sizes, so a large chunk or arity can not wrap them.
+ */
+void create_merkle_root(const char* data,size_t size,size_t chunk,size_t arity,unsigned char* root){
+	size_t count;
+	unsigned char* below;
+	merkle_job job;
+
+	if(chunk == 0 || arity < 2){
+		fprintf(stderr,"Unknown Merkle tree shape!\nExiting...\n");
+		exit(0);
+	}
+	count = size == 0 ? 1 : size / chunk + (size % chunk != 0);
+
+	job.data = data;
+	job.size = size;
+	job.chunk = chunk;
+	job.arity = arity;
+	job.digests = alloc_digests(count);
+	run_block_engine(count,merkle_leaf,&job);
+
+	while(count > 1){// one level up
+		below = job.digests;
+		job.below = below;
+		job.below_count = count;
+		count = count / arity + (count % arity != 0);
+		job.digests = alloc_digests(count);
+		run_block_engine(count,merkle_node,&job);
+		free(below);
+	}
+
+	memcpy(root,job.digests,32);
+	free(job.digests);
+}
+/**
+ *
+ * @param data Message
+ * @param size Size of the message
+ * @param chunk Bytes in a leaf chunk
+ * @param arity Children of a node
+ * @return Root of the tree as a hexadecimal string
+ *
+ * @brief Computes the root of the Merkle tree of the message, see create_merkle_root.
+ */
+char* create_merkle_hash(const char* data,size_t size,size_t chunk,size_t arity){
+	unsigned char root[32];
+
+	create_merkle_root(data,size,chunk,arity,root);
+	return digest_to_hex(root);
+}
+/**
+ *
+ * @param ds Digital signature
+ * @return true(1) if the signature is in the Merkle mode, false(0) otherwise
+ */
+int is_merkle_ds(char* ds){
+	return strncmp(ds,MERKLE_TAG,strlen(MERKLE_TAG)) == 0;
+}
+/**
+ *
+ * @param id Plain text
+ * @param id_size Size of the plain text
+ * @param ds Digital signature in the Merkle mode
+ * @return Root of the Merkle tree of the plain text as a hexadecimal string
+ *
+ * @brief Builds the tree described by the signature's first line over the received plain text.
+ *
+ * The line comes from the received message, so a shape that is not accepted by is_merkle_shape_valid is rejected.
+ */
+char* create_merkle_hash_for_ds(char* id,size_t id_size,char* ds){
+	size_t chunk,arity;
+
+	if(sscanf(ds,MERKLE_TAG "%zu %zu",&chunk,&arity) != 2 || !is_merkle_shape_valid(chunk,arity)){
+		fprintf(stderr,"Unknown Merkle signature!\nExiting...\n");
+		exit(0);
+	}
+	return create_merkle_hash(id,id_size,chunk,arity);
+}
+/**
+ *
+ * @param ds Digital signature in the Merkle mode
+ * @return The encrypted root, the part after the first line
+ */
+char* merkle_ds_signature(char* ds){
+	char* p = strchr(ds,'\n');
+
+	if(p == NULL){
+		fprintf(stderr,"Unknown Merkle signature!\nExiting...\n");
+		exit(0);
+	}
+	return p + 1;
+}
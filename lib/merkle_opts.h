@@ -0,0 +1,70 @@
+/**
+ * @file
+ * @brief Merkle tree signatures for very large messages.
+ *
+ * Plain SHA256 of a message is serial, so it runs on one core no matter how many threads are given. In the Merkle
+ * mode the message is cut into fixed size chunks which are hashed independently by the block engine, then the
+ * digests are hashed together level by level until a single root is left. The root is signed instead of the hash
+ * of the whole message. The chunk size and the arity of the tree are written in front of the signature, so the
+ * receiver builds the same tree, with its own threads.
+ */
+
+#ifndef MERKLE_OPTS_H_
+#define MERKLE_OPTS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sha256.h"
+#include "block_engine.h"
+#include "general_opts.h"
+
+/**
+ * Default size of a leaf chunk in bytes.
+ */
+#define MERKLE_CHUNK_SIZE (1 << 20)
+/**
+ * Default number of children of a node.
+ */
+#define MERKLE_ARITY 4
+/**
+ * Smallest leaf chunk a receiver accepts, the digests of the leaves are less than 1% of the message.
+ */
+#define MERKLE_MIN_CHUNK_SIZE 4096
+/**
+ * Largest leaf chunk a receiver accepts.
+ */
+#define MERKLE_MAX_CHUNK_SIZE (1 << 30)
+/**
+ * Largest arity a receiver accepts.
+ */
+#define MERKLE_MAX_ARITY 256
+/**
+ * First word of the signature line in the Merkle mode.
+ */
+#define MERKLE_TAG "merkle "
+
+/**
+ * @struct MERKLE_JOB
+ * @brief MERKLE_JOB holds one level of the tree for the block engine.
+ */
+typedef struct MERKLE_JOB {
+	const char* data; // message, for the leaves
+	size_t size; // size of the message
+	size_t chunk; // bytes in a leaf chunk
+	size_t arity; // children of a node
+	const unsigned char* below; // digests of the level below, for the nodes
+	size_t below_count; // number of digests in the level below
+	unsigned char* digests; // 32 byte digests of this level
+}merkle_job;
+
+void merkle_leaf(size_t i,void* arg);
+void merkle_node(size_t i,void* arg);
+int is_merkle_shape_valid(size_t chunk,size_t arity);
+void create_merkle_root(const char* data,size_t size,size_t chunk,size_t arity,unsigned char* root);
+char* create_merkle_hash(const char* data,size_t size,size_t chunk,size_t arity);
+int is_merkle_ds(char* ds);
+char* create_merkle_hash_for_ds(char* id,size_t id_size,char* ds);
+char* merkle_ds_signature(char* ds);
+
+#endif /* MERKLE_OPTS_H_ */
@@ -0,0 +1,175 @@
+/**
+ * @file
+ * @brief Output builder with a write cursor.
+ */
+
+#include "out_buf.h"
+
+/**
+ *
+ * @param cap Expected size of the output
+ * @return Empty output
+ *
+ * @brief Creates an empty output, the given size is allocated at once so an output which is sized right never grows.
+ */
+out_buf* create_out_buf(size_t cap){
+	out_buf* ob = (out_buf*)malloc(sizeof(out_buf));
+
+	ob->cap = cap + 1;
+	ob->size = 0;
+	if((ob->data = (char*)malloc(ob->cap*sizeof(char))) == NULL){
+		fprintf(stderr,"malloc Failed (create_out_buf)");
+		exit(0);
+	}
+	ob->data[0] = '\0';
+	return ob;
+}
+/**
+ *
+ * @param ob The output
+ *
+ * @brief Frees the output with its data.
+ */
+void free_out_buf(out_buf* ob){
+	free(ob->data);
+	free(ob);
+}
+/**
+ *
+ * @param ob The output
+ * @param n Bytes that will be written
+ *
+ * @brief Makes room for n more bytes and the termination char after the cursor.
+ *
+ * The output grows at least twice its size, so the total copy cost of the growth is linear.
+ */
+void out_buf_reserve(out_buf* ob,size_t n){
+	size_t cap = ob->cap;
+
+	if(ob->size + n + 1 <= cap)
+		return;
+	while(cap < ob->size + n + 1)
+		cap *= 2;
+	if((ob->data = (char*)realloc(ob->data,cap*sizeof(char))) == NULL){
+		fprintf(stderr,"realloc Failed (out_buf_reserve)");
+		exit(0);
+	}
+	ob->cap = cap;
+}
+/**
+ *
+ * @param ob The output
+ * @param data Data, it can have zero bytes
+ * @param size Size of the data
+ *
+ * @brief Writes the data at the cursor.
+ */
+void out_buf_append(out_buf* ob,const char* data,size_t size){
+	out_buf_reserve(ob,size);
+	memcpy(ob->data+ob->size,data,size);
+	ob->size += size;
+	ob->data[ob->size] = '\0';
+}
+/**
+ *
+ * @param ob The output
+ * @param str String
+ *
+ * @brief Writes the string at the cursor.
+ */
+void out_buf_append_str(out_buf* ob,const char* str){
+	out_buf_append(ob,str,strlen(str));
+}
+/**
+ *
+ * @param ob The output
+ * @param num The number
+ * @param base Base of the digits
+ * @param sep Character written after the number, nothing if it is the termination char
+ *
+ * @brief Writes the digits of the number at the cursor, they are formatted in place.
+ *
+ * mpz_sizeinbase can be one more than the number of digits, so the cursor is moved by the written digits.
+ */
+void out_buf_append_mpz(out_buf* ob,mpz_t num,int base,char sep){
+	out_buf_reserve(ob,mpz_sizeinbase(num,base) + 2); // digits, sign and separator
+	mpz_get_str(ob->data+ob->size,base,num);
+	ob->size += strlen(ob->data+ob->size);
+	if(sep != '\0')
+		ob->data[ob->size++] = sep;
+	ob->data[ob->size] = '\0';
+}
+/**
+ *
+ * @param ob The output
+ * @param size Size of the output, can be NULL
+ * @return The output, terminated with the termination char
+ *
+ * @brief Gives the output to the caller, the builder is freed.
+ */
+char* out_buf_release(out_buf* ob,size_t* size){
+	char* data = ob->data;
+
+	if(size != NULL)
+		*size = ob->size;
+	free(ob);
+	return data;
+}
+/**
+ *
+ * @param fd File descriptor
+ * @param iov Parts to write, they are changed while writing
+ * @param count Number of parts
+ *
+ * @brief Writes all parts with writev, a short write is continued from where it stopped.
+ */
+void write_iov_full(int fd,struct iovec* iov,int count){
+	ssize_t w;
+
+	while(count > 0){
+		w = writev(fd,iov,count > OUT_BUF_IOV_MAX ? OUT_BUF_IOV_MAX : count);
+		if(w < 0 && errno == EINTR)
+			continue;
+		if(w < 0){
+			fprintf(stderr,"writev failed. (write_iov_full)\n");
+			exit(0);
+		}
+		while(count > 0 && (size_t)w >= iov->iov_len){ // skip the parts which are written
+			w -= iov->iov_len;
+			iov++;
+			count--;
+		}
+		if(count > 0){
+			iov->iov_base = (char*)iov->iov_base + w;
+			iov->iov_len -= w;
+		}
+	}
+}
+/**
+ *
+ * @param ob The output, can be NULL
+ * @param fd File descriptor
+ * @param tail Data written after the output, it is not copied, can be NULL
+ * @param tail_size Size of the tail
+ *
+ * @brief Writes the output and the tail to the file descriptor in one writev, then the output is emptied.
+ */
+void out_buf_flush(out_buf* ob,int fd,const char* tail,size_t tail_size){
+	struct iovec iov[2];
+	int count = 0;
+
+	if(ob != NULL && ob->size > 0){
+		iov[count].iov_base = ob->data;
+		iov[count++].iov_len = ob->size;
+	}
+	if(tail != NULL && tail_size > 0){
+		iov[count].iov_base = (void*)tail;
+		iov[count++].iov_len = tail_size;
+	}
+	write_iov_full(fd,iov,count);
+
+	if(ob != NULL){
+		ob->size = 0;
+		ob->data[0] = '\0';
+	}
+}
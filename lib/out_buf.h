@@ -0,0 +1,47 @@
+/**
+ * @file
+ * @brief Output builder for the ciphered texts and the other generated texts.
+ *
+ * The builder keeps its write cursor, so each part is formatted straight to its place at the end of the output
+ * instead of searching the end of the string for every part like strcat does. Building an output of n parts is
+ * linear in its size. The output can be flushed to a file descriptor with writev, together with a data part that
+ * is not copied into the builder. It is implemented in out_buf.c.
+ */
+
+#ifndef OUT_BUF_H_
+#define OUT_BUF_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <gmp.h>
+
+/**
+ * Most parts given to one writev, the limit of Linux (IOV_MAX).
+ */
+#define OUT_BUF_IOV_MAX 1024
+
+/**
+ * @struct OUT_BUF
+ * @brief OUT_BUF is an output that grows at its end.
+ */
+typedef struct OUT_BUF {
+	char* data; // the output, always terminated with the termination char
+	size_t size; // write cursor, bytes in the output
+	size_t cap; // allocated bytes of data
+}out_buf;
+
+out_buf* create_out_buf(size_t cap);
+void free_out_buf(out_buf* ob);
+void out_buf_reserve(out_buf* ob,size_t n);
+void out_buf_append(out_buf* ob,const char* data,size_t size);
+void out_buf_append_str(out_buf* ob,const char* str);
+void out_buf_append_mpz(out_buf* ob,mpz_t num,int base,char sep);
+char* out_buf_release(out_buf* ob,size_t* size);
+void write_iov_full(int fd,struct iovec* iov,int count);
+void out_buf_flush(out_buf* ob,int fd,const char* tail,size_t tail_size);
+
+#endif /* OUT_BUF_H_ */
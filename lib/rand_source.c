@@ -0,0 +1,237 @@
+/**
+ * @file
+ * @brief Kernel and ChaCha20 random sources.
+ */
+
+#include "rand_source.h"
+
+/**
+ *
+ * @param buf Output buffer
+ * @param len Number of random bytes
+ *
+ * @brief Fills the buffer with random bytes from the operating system.
+ *
+ * The bytes come from getrandom(), they are used to seed the DRBGs and by the kernel source.
+ */
+void get_random_bytes(unsigned char* buf, size_t len){
+	ssize_t r;
+
+	while(len > 0){
+		r = getrandom(buf,len,0);
+		if(r < 0 && errno == EINTR)
+			continue;
+		if(r < 0){
+			fprintf(stderr,"getrandom failed (get_random_bytes)\n");
+			exit(0);
+		}
+		buf += r;
+		len -= r;
+	}
+}
+/**
+ *
+ * @param src The source
+ * @param buf Output buffer
+ * @param len Number of bytes
+ *
+ * @brief Fill function of the kernel source.
+ */
+void kernel_rand_fill(rand_source* src,unsigned char* buf,size_t len){
+	(void)src;
+	get_random_bytes(buf,len);
+}
+/**
+ *
+ * @param src The source
+ *
+ * @brief Frees a source without a state.
+ */
+void kernel_rand_destroy(rand_source* src){
+	free(src);
+}
+/**
+ *
+ * @return A source that reads getrandom() for every request
+ */
+rand_source* create_kernel_rand_source(void){
+	rand_source* src = (rand_source*)malloc(sizeof(rand_source));
+
+	src->fill = kernel_rand_fill;
+	src->destroy = kernel_rand_destroy;
+	src->state = NULL;
+	return src;
+}
+/**
+ *
+ * @param drbg The DRBG
+ *
+ * @brief Seeds the DRBG with a fresh key and nonce from getrandom().
+ */
+void chacha_drbg_seed(chacha_drbg* drbg){
+	unsigned char seed[CHACHA20_KEY_SIZE + CHACHA20_NONCE_SIZE];
+
+	get_random_bytes(seed,sizeof(seed));
+	chacha20_init(&drbg->cipher,seed,seed+CHACHA20_KEY_SIZE,0);
+	drbg->produced = 0;
+	drbg->fixed_seed = 0;
+	memset(seed,0,sizeof(seed));
+}
+/**
+ *
+ * @param src The source
+ * @param buf Output buffer
+ * @param len Number of bytes
+ *
+ * @brief Fill function of the ChaCha20 DRBG.
+ *
+ * The output is the key stream of the current key. After each request the next 32 bytes of the key stream become the
+ * new key, so a state that leaks later does not reveal the bytes that were already given out.
+ */
+void chacha_drbg_fill(rand_source* src,unsigned char* buf,size_t len){
+	chacha_drbg* drbg = (chacha_drbg*)src->state;
+	unsigned char key[CHACHA20_KEY_SIZE];
+	unsigned char nonce[CHACHA20_NONCE_SIZE];
+
+	if(drbg->produced >= RAND_RESEED_BYTES && !drbg->fixed_seed)
+		chacha_drbg_seed(drbg);
+
+	memset(buf,0,len);
+	chacha20_xor(&drbg->cipher,buf,buf,len);
+	drbg->produced += len;
+
+	// fast key erasure
+	memset(key,0,sizeof(key));
+	chacha20_xor(&drbg->cipher,key,key,sizeof(key));
+	memset(nonce,0,sizeof(nonce));
+	chacha20_init(&drbg->cipher,key,nonce,0);
+	memset(key,0,sizeof(key));
+}
+/**
+ *
+ * @param src The source
+ *
+ * @brief Frees the DRBG, its state is cleared first.
+ */
+void chacha_drbg_destroy(rand_source* src){
+	memset(src->state,0,sizeof(chacha_drbg));
+	free(src->state);
+	free(src);
+}
+/**
+ *
+ * @return A new ChaCha20 DRBG seeded from getrandom()
+ */
+rand_source* create_chacha_rand_source(void){
+	rand_source* src = (rand_source*)malloc(sizeof(rand_source));
+	chacha_drbg* drbg = (chacha_drbg*)malloc(sizeof(chacha_drbg));
+
+	chacha_drbg_seed(drbg);
+	src->fill = chacha_drbg_fill;
+	src->destroy = chacha_drbg_destroy;
+	src->state = drbg;
+	return src;
+}
+/**
+ *
+ * @param seed The seed
+ * @param len Length of the seed, at most CHACHA20_KEY_SIZE + CHACHA20_NONCE_SIZE bytes are used
+ * @return A ChaCha20 DRBG that gives the same bytes for the same seed
+ *
+ * @brief Creates a DRBG with a fixed seed, for the benchmarks and tests that need the same keys in every run.
+ *
+ * It must not be used for real keys.
+ */
+rand_source* create_seeded_chacha_rand_source(const unsigned char* seed,size_t len){
+	rand_source* src = (rand_source*)malloc(sizeof(rand_source));
+	chacha_drbg* drbg = (chacha_drbg*)malloc(sizeof(chacha_drbg));
+	unsigned char buf[CHACHA20_KEY_SIZE + CHACHA20_NONCE_SIZE];
+
+	memset(buf,0,sizeof(buf));
+	memcpy(buf,seed,len < sizeof(buf) ? len : sizeof(buf));
+	chacha20_init(&drbg->cipher,buf,buf+CHACHA20_KEY_SIZE,0);
+	drbg->produced = 0;
+	drbg->fixed_seed = 1;
+	src->fill = chacha_drbg_fill;
+	src->destroy = chacha_drbg_destroy;
+	src->state = drbg;
+	return src;
+}
+/**
+ *
+ * @param src The source
+ * @param buf Output buffer
+ * @param len Number of bytes
+ *
+ * @brief Writes len random bytes from the source to buf.
+ */
+void rand_bytes(rand_source* src,unsigned char* buf,size_t len){
+	src->fill(src,buf,len);
+}
+/**
+ *
+ * @param src The source
+ * @param rop Random number
+ * @param bits Bit length
+ *
+ * @brief Sets rop to a random number below 2^bits.
+ *
+ * The limbs are filled in bulk with one request and read with mpz_import, there is no bit string.
+ */
+void rand_mpz_bits(rand_source* src,mpz_t rop,size_t bits){
+	size_t bytes = (bits + 7) / 8;
+	unsigned char* buf;
+
+	if(bits == 0){
+		mpz_set_ui(rop,0);
+		return;
+	}
+	buf = (unsigned char*)malloc(bytes);
+	rand_bytes(src,buf,bytes);
+	mpz_import(rop,bytes,1,1,0,0,buf);
+	mpz_fdiv_r_2exp(rop,rop,bits); /// drop the extra bits of the top byte
+	memset(buf,0,bytes);
+	free(buf);
+}
+/**
+ * Key of the thread's source.
+ */
+static pthread_key_t thread_rand_key;
+
+/**
+ * Makes sure thread_rand_key is created once.
+ */
+static pthread_once_t thread_rand_once = PTHREAD_ONCE_INIT;
+
+/**
+ *
+ * @param src The thread's source
+ *
+ * @brief Frees the thread's source when the thread exits.
+ */
+void thread_rand_destructor(void* src){
+	((rand_source*)src)->destroy((rand_source*)src);
+}
+/**
+ * @brief Creates the key of the thread sources.
+ */
+void thread_rand_key_init(void){
+	pthread_key_create(&thread_rand_key,thread_rand_destructor);
+}
+/**
+ *
+ * @return The ChaCha20 DRBG of the calling thread
+ *
+ * @brief Returns the thread's own DRBG, it is created at the first call of each thread.
+ */
+rand_source* get_thread_rand_source(void){
+	rand_source* src;
+
+	pthread_once(&thread_rand_once,thread_rand_key_init);
+	src = (rand_source*)pthread_getspecific(thread_rand_key);
+	if(src == NULL){
+		src = create_chacha_rand_source();
+		pthread_setspecific(thread_rand_key,src);
+	}
+	return src;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file
+ * @brief Random sources for the key material, session keys and nonces.
+ *
+ * A random source is a small interface with a fill function, so the generator behind it can be changed.
+ * There are two sources: the kernel source reads getrandom() directly, and the ChaCha20 DRBG is seeded from
+ * getrandom() and then produces its output with the ChaCha20 block function, which is much faster for the
+ * large amounts of random bits needed by the key generation. Each thread gets its own DRBG with
+ * get_thread_rand_source, so the threads never share a state or wait on a lock.
+ */
+
+#ifndef RAND_SOURCE_H_
+#define RAND_SOURCE_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/random.h>
+#include <gmp.h>
+#include "chacha20.h"
+
+/**
+ * The ChaCha20 DRBG is seeded again from getrandom() after producing this many bytes.
+ */
+#define RAND_RESEED_BYTES ((size_t)1 << 30)
+
+/**
+ * @struct RAND_SOURCE
+ * @brief RAND_SOURCE is a generator of random bytes.
+ */
+typedef struct RAND_SOURCE {
+	void (*fill)(struct RAND_SOURCE* src,unsigned char* buf,size_t len); // writes len random bytes to buf
+	void (*destroy)(struct RAND_SOURCE* src); // frees the source
+	void* state; // state of the generator
+}rand_source;
+
+/**
+ * @struct CHACHA_DRBG
+ * @brief CHACHA_DRBG is the state of the ChaCha20 DRBG.
+ */
+typedef struct CHACHA_DRBG {
+	chacha20_ctx cipher; // key stream of the current key
+	size_t produced; // bytes produced since the last seeding
+	int fixed_seed; // 1 if the seed was given, it is never seeded again from getrandom()
+}chacha_drbg;
+
+void get_random_bytes(unsigned char* buf, size_t len);
+void kernel_rand_fill(rand_source* src,unsigned char* buf,size_t len);
+void kernel_rand_destroy(rand_source* src);
+rand_source* create_kernel_rand_source(void);
+void chacha_drbg_seed(chacha_drbg* drbg);
+void chacha_drbg_fill(rand_source* src,unsigned char* buf,size_t len);
+void chacha_drbg_destroy(rand_source* src);
+rand_source* create_chacha_rand_source(void);
+rand_source* create_seeded_chacha_rand_source(const unsigned char* seed,size_t len);
+void rand_bytes(rand_source* src,unsigned char* buf,size_t len);
+void rand_mpz_bits(rand_source* src,mpz_t rop,size_t bits);
+
+void thread_rand_destructor(void* src);
+void thread_rand_key_init(void);
+rand_source* get_thread_rand_source(void);
+
+#endif /* RAND_SOURCE_H_ */
@@ -0,0 +1,380 @@
+/**
+ * @file
+ * @brief RSA key generation and the key contexts.
+ */
+
+#include "rsa_opts.h"
+
+/**
+ * Modulus size of the Blum Blum Shub engines of the key generation, 0 for the ChaCha20 DRBG.
+ */
+static int rsa_bbs_modulus_bits = 0;
+
+/**
+ *
+ * @param bits Bit length of the Blum Blum Shub modulus, 0 to use the ChaCha20 DRBG
+ *
+ * @brief Makes the key generation draw p and q from Blum Blum Shub engines.
+ */
+void set_rsa_bbs_modulus_bits(int bits){
+	if(bits != 0 && bits < 512){
+		fprintf(stderr,"The Blum Blum Shub modulus has to be at least 512 bits\n");
+		exit(0);
+	}
+	rsa_bbs_modulus_bits = bits;
+}
+/**
+ *
+ * @param arg The job
+ * @return NULL
+ *
+ * @brief Searches for the prime of the job.
+ *
+ * With a fixed public exponent, primes whose prime - 1 has a common factor with e are thrown away. When a Blum Blum Shub
+ * modulus size is set, the job has its own BBS engine and draws all of its candidates from it.
+ */
+void* prime_job_thread(void* arg){
+	prime_job* job = (prime_job*)arg;
+	rand_source* src = rsa_bbs_modulus_bits > 0 ? create_bbs_rand_source(rsa_bbs_modulus_bits) : get_thread_rand_source();
+
+	job->prime = create_random_prime_gmp_number_from_source(src,job->bits,job->threads);
+	while(job->e != 0){
+		mpz_sub_ui(*job->prime,*job->prime,1);
+		if(mpz_gcd_ui(NULL,*job->prime,job->e) == 1){// e is invertible mod prime - 1
+			mpz_add_ui(*job->prime,*job->prime,1);
+			break;
+		}
+		mpz_clear(*job->prime);
+		free(job->prime);
+		job->prime = create_random_prime_gmp_number_from_source(src,job->bits,job->threads);
+	}
+	if(rsa_bbs_modulus_bits > 0)
+		src->destroy(src);
+	return NULL;
+}
+/**
+ * @param key_length Indicates the key length for p and q
+ * @param e Fixed public exponent, 0 for a random full size exponent
+ * @return The base for the public and private keys.
+ *
+ * @brief Generates key base(p and q), for generation of public and private keys.
+ *
+ * The function generates big prime numbers p and q with the help of the ChaCha20 DRBG of each thread with the desired
+ * bit length. Then calculates n and phi according to formulas and packs all calculated values in a rsa_key_base structure.
+ * p and q are searched at the same time on their own threads, and the threads of the block engine are shared
+ * between the two searches, each testing disjoint ranges of candidates. With a fixed e, p and q are searched until
+ * gcd(e, p-1) = gcd(e, q-1) = 1, so e is invertible mod phi.
+ */
+rsa_key_base* generate_rsa_key_base_e(int key_length,unsigned long e){
+	rsa_key_base* key_base = (rsa_key_base*)malloc(sizeof(rsa_key_base));
+	prime_job jobs[2];
+	pthread_t tid;
+
+	if(key_length == 0){
+		key_length = PQBITLENGTH;
+	}
+	else{
+		key_length /= 2;
+	}
+
+	//initialize gmp numbers
+	mpz_init(key_base->p);
+	mpz_init(key_base->q);
+	mpz_init(key_base->n);
+	mpz_init(key_base->phi);
+	key_base->e = e;
+
+	// generate random prime numbers p and q with bit length PQBITLENGTH, concurrently
+	jobs[0].bits = jobs[1].bits = key_length;
+	jobs[0].e = jobs[1].e = e;
+	jobs[0].threads = (block_engine_threads + 1) / 2;
+	jobs[1].threads = block_engine_threads / 2 > 0 ? block_engine_threads / 2 : 1;
+	do {
+		if(pthread_create(&tid,NULL,prime_job_thread,&jobs[0]) != 0){
+			fprintf(stderr,"pthread_create failed (generate_rsa_key_base)\n");
+			exit(0);
+		}
+		prime_job_thread(&jobs[1]);
+		pthread_join(tid,NULL);
+
+		mpz_set(key_base->p,*jobs[0].prime);
+		mpz_set(key_base->q,*jobs[1].prime);
+		mpz_clear(*jobs[0].prime);
+		mpz_clear(*jobs[1].prime);
+		free(jobs[0].prime);
+		free(jobs[1].prime);
+	}while(mpz_cmp(key_base->p,key_base->q) == 0);
+
+	///n = p x q
+	mpz_mul(key_base->n,key_base->p,key_base->q);
+
+	///phi = (p-1) x (q-1) = p x q - p - q + 1
+	mpz_mul(key_base->phi,key_base->p,key_base->q);//p x q
+	mpz_sub(key_base->phi,key_base->phi,key_base->p); // (p x q) - p
+	mpz_sub(key_base->phi,key_base->phi,key_base->q); // ((p x q) - p) -q
+	mpz_add_ui(key_base->phi,key_base->phi,1); // (((p x q) - p) -q) + 1
+
+	return key_base;
+}
+/**
+ * @param key_length Indicates the key length for p and q
+ * @return The base for the public and private keys.
+ *
+ * @brief Generates key base(p and q) for the default public exponent RSA_DEFAULT_E.
+ */
+rsa_key_base* generate_rsa_key_base(int key_length){
+	return generate_rsa_key_base_e(key_length,RSA_DEFAULT_E);
+}
+/**
+ *
+ * @param key_base The calculated p and q values.
+ * @return Public and Private keys.
+ *
+ * @brief Computes public and private keys according to the given rsa_key_base.
+ *
+ * Although its name is create_pub_key the function generate both public and private keys.
+ * The public and private keys are computed via GMP Library functions since we are dealing with big
+ * numbers. The e is the public key's part, it is the fixed exponent of the key base or, if there is none, generated randomly.
+ * And d is generated according to e by inverse modular operation.
+ */
+rsa_keys* create_pub_key(rsa_key_base* key_base){
+	rsa_keys* keys = (rsa_keys*)malloc(sizeof(rsa_keys));
+	gmp_randstate_t state;
+	mpz_t e,d,temp;
+
+	//initialize gmp numbers to 300
+	mpz_init_set_ui(e,300);
+	mpz_init_set_ui(d,300);
+	mpz_init(temp);
+
+	mpz_init(keys->pr);
+	mpz_init(keys->pu);
+	mpz_init(keys->n);
+	mpz_init(keys->p);
+	mpz_init(keys->q);
+	mpz_init(keys->dp);
+	mpz_init(keys->dq);
+	mpz_init(keys->qinv);
+
+	if(key_base->e != 0){// p and q are chosen so that e is invertible
+		mpz_set_ui(e,key_base->e);
+		if(mpz_invert(temp,e,key_base->phi) == 0){
+			fprintf(stderr,"The public exponent is not invertible mod phi!\nExiting...\n");
+			exit(0);
+		}
+	}
+	else{
+		/* determine a random number less than phi, e, and gcd(e,phi) = 1
+		 * then conduct a modular inversion operation to e in order to calculate d
+		 * if e is not modularly invertable find another e value and calculate d again
+		 * the random state is seeded once, not for each try
+		 */
+		seed_prime_randstate(state);
+		do {
+			do {
+				mpz_urandomm(e,state,key_base->phi); //a random number mod phi
+				mpz_gcd(temp,e,key_base->phi);// take the gcd(e,phi)
+
+				while(mpz_cmp_ui(temp,1) != 0){// if gcd(e,phi) != 1 change e
+					mpz_sub_ui(e,e,1);// each time check is not satisfy our condition subtract 1
+					mpz_gcd(temp,e,key_base->phi);// take the gcd(e,phi)
+				}
+			}while(mpz_cmp_ui(e,1) == 0);// if e == 1 generate another random number
+		}while(mpz_invert(temp,e,key_base->phi) == 0); //if e is not invertable do the same operations again
+		gmp_randclear(state);
+	}
+
+	mpz_set(d,temp); // both keys are generated at this point
+
+	//set keys
+	mpz_set(keys->pu,e);
+	mpz_set(keys->pr,d);
+	mpz_set(keys->n,key_base->n);
+
+	//set the CRT components of the private key
+	mpz_set(keys->p,key_base->p);
+	mpz_set(keys->q,key_base->q);
+	mpz_sub_ui(temp,key_base->p,1);
+	mpz_mod(keys->dp,d,temp); // dp = d mod (p-1)
+	mpz_sub_ui(temp,key_base->q,1);
+	mpz_mod(keys->dq,d,temp); // dq = d mod (q-1)
+	mpz_invert(keys->qinv,key_base->q,key_base->p); // qinv = q^-1 mod p
+
+	mpz_clear(e);
+	clear_secret_mpz(d);
+	clear_secret_mpz(temp);
+	return keys;
+}
+/**
+ *
+ * @param x A secret number
+ *
+ * @brief Overwrites the limbs of the number with zeros and frees it, so the freed memory does not keep the secret.
+ */
+void clear_secret_mpz(mpz_t x){
+	size_t limbs = mpz_size(x);
+
+	if(limbs > 0)
+		memset(mpz_limbs_modify(x,limbs),0,limbs*sizeof(mp_limb_t));
+	mpz_clear(x);
+}
+/**
+ *
+ * @param key_base The key base
+ *
+ * @brief Frees the key base, p, q and phi are overwritten first.
+ */
+void free_rsa_key_base(rsa_key_base* key_base){
+	if(key_base == NULL)
+		return;
+	clear_secret_mpz(key_base->p);
+	clear_secret_mpz(key_base->q);
+	clear_secret_mpz(key_base->phi);
+	mpz_clear(key_base->n);
+	free(key_base);
+}
+/**
+ *
+ * @param keys The keys
+ *
+ * @brief Frees the keys, the private values are overwritten first.
+ */
+void free_rsa_keys(rsa_keys* keys){
+	if(keys == NULL)
+		return;
+	clear_secret_mpz(keys->pr);
+	clear_secret_mpz(keys->p);
+	clear_secret_mpz(keys->q);
+	clear_secret_mpz(keys->dp);
+	clear_secret_mpz(keys->dq);
+	clear_secret_mpz(keys->qinv);
+	mpz_clear(keys->pu);
+	mpz_clear(keys->n);
+	free(keys);
+}
+/**
+ *
+ * @param key The key
+ * @return Precomputed values of the key
+ *
+ * @brief Builds the context of the key.
+ *
+ * The Montgomery constants and the recoded exponents are computed here once, so the blocks of a message
+ * and the messages that use the same key do not compute them again.
+ */
+rsa_key_ctx* create_rsa_key_ctx(rsa_key* key){
+	rsa_key_ctx* ctx = (rsa_key_ctx*)malloc(sizeof(rsa_key_ctx));
+
+	ctx->n = create_mont_ctx(key->n);
+	ctx->k = recode_exponent(key->k);
+
+	if(key->crt){
+		ctx->p = create_mont_ctx(key->p);
+		ctx->q = create_mont_ctx(key->q);
+		ctx->dp = recode_exponent(key->dp);
+		ctx->dq = recode_exponent(key->dq);
+	}
+	else{
+		ctx->p = NULL;
+		ctx->q = NULL;
+		ctx->dp = NULL;
+		ctx->dq = NULL;
+	}
+	return ctx;
+}
+/**
+ *
+ * @param ctx Context of the key
+ *
+ * @brief Frees the context of the key.
+ */
+void free_rsa_key_ctx(rsa_key_ctx* ctx){
+	if(ctx == NULL)
+		return;
+	free_mont_ctx(ctx->n);
+	free_exp_windows(ctx->k);
+	if(ctx->dp != NULL){
+		free_mont_ctx(ctx->p);
+		free_mont_ctx(ctx->q);
+		free_exp_windows(ctx->dp);
+		free_exp_windows(ctx->dq);
+	}
+	free(ctx);
+}
+/**
+ *
+ * @param key The key
+ * @return Precomputed values of the key
+ *
+ * @brief Returns the context of the key, it is built if the key does not have one yet.
+ *
+ * The context is only read by the exponentiations, so once it is built the key can be shared by threads.
+ */
+rsa_key_ctx* get_rsa_key_ctx(rsa_key* key){
+	if(key->ctx == NULL)
+		key->ctx = create_rsa_key_ctx(key);
+	return key->ctx;
+}
+/**
+ *
+ * @param rop Result of the exponentiation
+ * @param base Base number
+ * @param w Recoded exponent
+ * @param mctx Montgomery constants of the modulo number, NULL if there are none
+ * @param mod Modulo number
+ *
+ * @brief Does the exponentiation with the precomputed values of a key.
+ */
+void exp_with_key_ctx(mpz_t rop, mpz_t base, exp_windows* w, mont_ctx* mctx, mpz_t mod){
+	if(mctx != NULL)
+		exp_with_windows_mont(rop,base,w,mctx);
+	else
+		exp_with_windows(rop,base,w,mod);
+}
+/**
+ *
+ * @param rop Result of the exponentiation
+ * @param base Base number
+ * @param key Key whose exponent and modulo are used
+ *
+ * @brief Does the RSA exponentiation rop = base^k mod n with the given key.
+ *
+ * If the key carries the CRT components (p, q, dp, dq, qinv) the exponentiation is split into two
+ * half size exponentiations mod p and mod q which are combined with Garner's formula. This is about
+ * 3-4 times faster than the full size exponentiation. Keys without the CRT components (public keys and
+ * old private key files that only have d and n) use the full size exponentiation mod n, or exp_short_mont
+ * when the exponent is short like the default public exponent 65537.
+ * The precomputed context of the key is built at the first call if the key does not have one yet. m1, m2 and h are
+ * numbers of the thread's arena, so they keep their limbs from one block to the next.
+ *
+ * m1 = c^dp mod p, m2 = c^dq mod q, h = qinv x (m1 - m2) mod p, m = m2 + h x q
+ */
+void rsa_key_exp(mpz_t rop, mpz_t base, rsa_key* key){
+	rsa_key_ctx* ctx = get_rsa_key_ctx(key);
+	arena* scratch;
+	mpz_ptr m1,m2,h;
+
+	if(!key->crt){// no CRT components, do it the old way
+		if(ctx->n != NULL && mpz_fits_ulong_p(key->k))// short public exponent like 65537
+			exp_short_mont(rop,base,mpz_get_ui(key->k),ctx->n);
+		else
+			exp_with_key_ctx(rop,base,ctx->k,ctx->n,key->n);
+		return;
+	}
+
+	scratch = get_thread_arena();
+	m1 = scratch->num[ARENA_NUM_CRT];
+	m2 = scratch->num[ARENA_NUM_CRT+1];
+	h = scratch->num[ARENA_NUM_CRT+2];
+
+	mpz_mod(h,base,key->p); // reduce the base mod p
+	exp_with_key_ctx(m1,h,ctx->dp,ctx->p,key->p); // m1 = c^dp mod p
+	mpz_mod(h,base,key->q); // reduce the base mod q
+	exp_with_key_ctx(m2,h,ctx->dq,ctx->q,key->q); // m2 = c^dq mod q
+
+	mpz_sub(h,m1,m2); // h = m1 - m2
+	mpz_mul(h,h,key->qinv); // h = qinv x (m1 - m2)
+	mpz_mod(h,h,key->p); // h = qinv x (m1 - m2) mod p
+	mpz_mul(h,h,key->q); // h = h x q
+	mpz_add(rop,m2,h); // m = m2 + h x q
+}
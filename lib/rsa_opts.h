@@ -11,12 +11,18 @@
 
 #include <stdlib.h>
 #include <gmp.h>
+#include <pthread.h>
 #include "math_opts.h"
+#include "block_engine.h"
 
 /**
  * Default bit length for p and q.
  */
 #define PQBITLENGTH 512
+/**
+ * Default public exponent, 0 means a random full size exponent.
+ */
+#define RSA_DEFAULT_E 65537
 
 /**
  * @struct RSA_KEY_BASE
@@ -27,6 +33,7 @@ typedef struct RSA_KEY_BASE {
 	mpz_t q; // q as GMP integer
 	mpz_t phi; // phi as GMP integer
 	mpz_t n; // n as GMP integer
+	unsigned long e; // fixed public exponent, 0 for a random one
 }rsa_key_base;
 /**
  * @struct RSA_KEYS
@@ -37,7 +44,11 @@ typedef struct RSA_KEYS {
 	mpz_t pu;// Public key as GMP integer
 	mpz_t pr;// Private key as GMP integer
 	mpz_t n; // n as GMP integer
-
+	mpz_t p; // p as GMP integer
+	mpz_t q; // q as GMP integer
+	mpz_t dp; // d mod (p-1) as GMP integer
+	mpz_t dq; // d mod (q-1) as GMP integer
+	mpz_t qinv; // q^-1 mod p as GMP integer
 }rsa_keys;
 /**
  * @struct RSA_KEY
@@ -46,107 +57,53 @@ typedef struct RSA_KEYS {
 typedef struct RSA_KEY {
 	mpz_t k; // e(public) or d(private) key as GMP integer
 	mpz_t n; // n as GMP integer
+	int crt; // 1 if the CRT components below are loaded, 0 otherwise
+	mpz_t p; // p as GMP integer (private keys only)
+	mpz_t q; // q as GMP integer (private keys only)
+	mpz_t dp; // d mod (p-1) as GMP integer (private keys only)
+	mpz_t dq; // d mod (q-1) as GMP integer (private keys only)
+	mpz_t qinv; // q^-1 mod p as GMP integer (private keys only)
+	struct RSA_KEY_CTX* ctx; // precomputed values of the key, built once and used for all the blocks
 }rsa_key;
-
 /**
- * @param key_length Indicates the key length for p and q
- * @return The base for the public and private keys.
- *
- * @brief Generates key base(p and q), for generation of public and private keys.
+ * @struct RSA_KEY_CTX
+ * @brief RSA_KEY_CTX holds the values that only depend on the key and are needed by every exponentiation.
  *
- * The function generates big prime numbers p and q with the help of blum blum shub RNG with the desired bit length.
- * Then calculates n and phi according to formulas and packs all calculated values in a rsa_key_base structure.
+ * These are the Montgomery constants of the modulo numbers and the exponents recoded into sliding windows.
+ * The CRT members are only set for CRT keys.
  */
-rsa_key_base* generate_rsa_key_base(int key_length){
-	rsa_key_base* key_base = (rsa_key_base*)malloc(sizeof(rsa_key_base));
-
-	if(key_length == 0){
-		key_length = PQBITLENGTH;
-	}
-	else{
-		key_length /= 2;
-	}
-	mpz_t* temp;
-
-	//initialize gmp numbers
-	mpz_init(key_base->p);
-	mpz_init(key_base->q);
-	mpz_init(key_base->n);
-	mpz_init(key_base->phi);
-
-	// generate random prime numbers p and q with bit length PQBITLENGTH
-	temp = create_random_prime_gmp_number_with_bbs(key_length);
-	mpz_set(key_base->p,*temp);
-	free(temp);
-	temp = create_random_prime_gmp_number_with_bbs(key_length);
-	mpz_set(key_base->q,*temp);
-	free(temp);
-
-	///n = p x q
-	mpz_mul(key_base->n,key_base->p,key_base->q);
-
-	///phi = (p-1) x (q-1) = p x q - p - q + 1
-	mpz_mul(key_base->phi,key_base->p,key_base->q);//p x q
-	mpz_sub(key_base->phi,key_base->phi,key_base->p); // (p x q) - p
-	mpz_sub(key_base->phi,key_base->phi,key_base->q); // ((p x q) - p) -q
-	mpz_add_ui(key_base->phi,key_base->phi,1); // (((p x q) - p) -q) + 1
-
-	return key_base;
-}
+typedef struct RSA_KEY_CTX {
+	mont_ctx* n; // Montgomery constants of n
+	exp_windows* k; // recoded e or d
+	mont_ctx* p; // Montgomery constants of p
+	mont_ctx* q; // Montgomery constants of q
+	exp_windows* dp; // recoded d mod (p-1)
+	exp_windows* dq; // recoded d mod (q-1)
+}rsa_key_ctx;
+
+void set_rsa_bbs_modulus_bits(int bits);
 /**
- *
- * @param key_base The calculated p and q values.
- * @return Public and Private keys.
- *
- * @brief Computes public and private keys according to the given rsa_key_base.
- *
- * Although its name is create_pub_key the function generate both public and private keys.
- * The public and private keys are computed via GMP Library functions since we are dealing with big
- * numbers. The e is the public key's part and generated randomly. And d is generated according to e by inverse modular operation.
+ * @struct PRIME_JOB
+ * @brief PRIME_JOB is one of the primes of a key, searched on its own thread.
  */
-rsa_keys* create_pub_key(rsa_key_base* key_base){
-	rsa_keys* keys = (rsa_keys*)malloc(sizeof(rsa_keys));
-	mpz_t e,d,temp;
-	unsigned long int seed = time(NULL);
-
-	//initialize gmp numbers to 300
-	mpz_init_set_ui(e,300);
-	mpz_init_set_ui(d,300);
-	mpz_init(temp);
-
-	mpz_init(keys->pr);
-	mpz_init(keys->pu);
-	mpz_init(keys->n);
-
-	/* determine a random number less than phi, e, and gcd(e,phi) = 1
-	 * then conduct a modular inversion operation to e in order to calculate d
-	 * if e is not modularly invertable find another e value and calculate d again
-	 */
-	do {
-		do {
-			generate_gmp_rand_num(e,key_base->phi,seed++); //a random number mod phi
-			mpz_gcd(temp,e,key_base->phi);// take the gcd(e,phi)
-
-			while(mpz_cmp_ui(temp,1) != 0){// if gcd(e,phi) != 1 change e
-				mpz_sub_ui(e,e,1);// each time check is not satisfy our condition subtract 1
-				mpz_gcd(temp,e,key_base->phi);// take the gcd(e,phi)
-			}
-		}while(mpz_cmp_ui(e,1) == 0);// if e == 1 generate another random number with another seed
-	}while(mpz_invert(temp,e,key_base->phi) == 0); //if e is not invertable do the same operations again
-
-	mpz_set(d,temp); // both keys are generated at this point
-
-	//set keys
-	mpz_set(keys->pu,e);
-	mpz_set(keys->pr,d);
-	mpz_set(keys->n,key_base->n);
-
-
-	mpz_clear(e);
-	mpz_clear(d);
-	mpz_clear(temp);
-	return keys;
-}
-
+typedef struct PRIME_JOB {
+	mpz_t* prime; // the prime found
+	int bits; // bit length of the prime
+	int threads; // threads searching for this prime
+	unsigned long e; // the prime is searched again until gcd(e, prime - 1) = 1, 0 for no check
+}prime_job;
+
+void* prime_job_thread(void* arg);
+rsa_key_base* generate_rsa_key_base_e(int key_length,unsigned long e);
+rsa_key_base* generate_rsa_key_base(int key_length);
+rsa_keys* create_pub_key(rsa_key_base* key_base);
+void clear_secret_mpz(mpz_t x);
+void free_rsa_key_base(rsa_key_base* key_base);
+void free_rsa_keys(rsa_keys* keys);
+rsa_key_ctx* create_rsa_key_ctx(rsa_key* key);
+void free_rsa_key_ctx(rsa_key_ctx* ctx);
+rsa_key_ctx* get_rsa_key_ctx(rsa_key* key);
+void exp_with_key_ctx(mpz_t rop, mpz_t base, exp_windows* w, mont_ctx* mctx, mpz_t mod);
+void rsa_key_exp(mpz_t rop, mpz_t base, rsa_key* key);
 
 #endif /* RSA_OPTS_H_ */
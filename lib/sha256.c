@@ -0,0 +1,524 @@
+/**
+ * @file
+ * @brief The SHA-256 compression functions, their runtime dispatch and the hashing API.
+ *
+ * @author Christophe Devine
+ */
+
+/*
+ *  FIPS-180-2 compliant SHA-256 implementation
+ *
+ *  Copyright (C) 2001-2003  Christophe Devine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "sha256.h"
+
+#define GET_UINT32(n,b,i)                       \
+{                                               \
+(n) = ( (uint32) (b)[(i)    ] << 24 )       \
+| ( (uint32) (b)[(i) + 1] << 16 )       \
+| ( (uint32) (b)[(i) + 2] <<  8 )       \
+| ( (uint32) (b)[(i) + 3]       );      \
+}
+
+#define PUT_UINT32(n,b,i)                       \
+{                                               \
+(b)[(i)    ] = (uint8) ( (n) >> 24 );       \
+(b)[(i) + 1] = (uint8) ( (n) >> 16 );       \
+(b)[(i) + 2] = (uint8) ( (n) >>  8 );       \
+(b)[(i) + 3] = (uint8) ( (n)       );       \
+}
+
+void sha256_starts( sha256_context *ctx )
+{
+    ctx->total[0] = 0;
+    ctx->total[1] = 0;
+
+    ctx->state[0] = 0x6A09E667;
+    ctx->state[1] = 0xBB67AE85;
+    ctx->state[2] = 0x3C6EF372;
+    ctx->state[3] = 0xA54FF53A;
+    ctx->state[4] = 0x510E527F;
+    ctx->state[5] = 0x9B05688C;
+    ctx->state[6] = 0x1F83D9AB;
+    ctx->state[7] = 0x5BE0CD19;
+}
+
+void sha256_process( sha256_context *ctx, uint8 data[64] )
+{
+    uint32 temp1, temp2, W[64];
+    uint32 A, B, C, D, E, F, G, H;
+
+    GET_UINT32( W[0],  data,  0 );
+    GET_UINT32( W[1],  data,  4 );
+    GET_UINT32( W[2],  data,  8 );
+    GET_UINT32( W[3],  data, 12 );
+    GET_UINT32( W[4],  data, 16 );
+    GET_UINT32( W[5],  data, 20 );
+    GET_UINT32( W[6],  data, 24 );
+    GET_UINT32( W[7],  data, 28 );
+    GET_UINT32( W[8],  data, 32 );
+    GET_UINT32( W[9],  data, 36 );
+    GET_UINT32( W[10], data, 40 );
+    GET_UINT32( W[11], data, 44 );
+    GET_UINT32( W[12], data, 48 );
+    GET_UINT32( W[13], data, 52 );
+    GET_UINT32( W[14], data, 56 );
+    GET_UINT32( W[15], data, 60 );
+
+#define  SHR(x,n) ((x & 0xFFFFFFFF) >> n)
+#define ROTR(x,n) (SHR(x,n) | (x << (32 - n)))
+
+#define S0(x) (ROTR(x, 7) ^ ROTR(x,18) ^  SHR(x, 3))
+#define S1(x) (ROTR(x,17) ^ ROTR(x,19) ^  SHR(x,10))
+
+#define S2(x) (ROTR(x, 2) ^ ROTR(x,13) ^ ROTR(x,22))
+#define S3(x) (ROTR(x, 6) ^ ROTR(x,11) ^ ROTR(x,25))
+
+#define F0(x,y,z) ((x & y) | (z & (x | y)))
+#define F1(x,y,z) (z ^ (x & (y ^ z)))
+
+#define R(t)                                    \
+(                                               \
+W[t] = S1(W[t -  2]) + W[t -  7] +          \
+S0(W[t - 15]) + W[t - 16]            \
+)
+
+#define P(a,b,c,d,e,f,g,h,x,K)                  \
+{                                               \
+temp1 = h + S3(e) + F1(e,f,g) + K + x;      \
+temp2 = S2(a) + F0(a,b,c);                  \
+d += temp1; h = temp1 + temp2;              \
+}
+
+    A = ctx->state[0];
+    B = ctx->state[1];
+    C = ctx->state[2];
+    D = ctx->state[3];
+    E = ctx->state[4];
+    F = ctx->state[5];
+    G = ctx->state[6];
+    H = ctx->state[7];
+
+    P( A, B, C, D, E, F, G, H, W[ 0], 0x428A2F98 );
+    P( H, A, B, C, D, E, F, G, W[ 1], 0x71374491 );
+    P( G, H, A, B, C, D, E, F, W[ 2], 0xB5C0FBCF );
+    P( F, G, H, A, B, C, D, E, W[ 3], 0xE9B5DBA5 );
+    P( E, F, G, H, A, B, C, D, W[ 4], 0x3956C25B );
+    P( D, E, F, G, H, A, B, C, W[ 5], 0x59F111F1 );
+    P( C, D, E, F, G, H, A, B, W[ 6], 0x923F82A4 );
+    P( B, C, D, E, F, G, H, A, W[ 7], 0xAB1C5ED5 );
+    P( A, B, C, D, E, F, G, H, W[ 8], 0xD807AA98 );
+    P( H, A, B, C, D, E, F, G, W[ 9], 0x12835B01 );
+    P( G, H, A, B, C, D, E, F, W[10], 0x243185BE );
+    P( F, G, H, A, B, C, D, E, W[11], 0x550C7DC3 );
+    P( E, F, G, H, A, B, C, D, W[12], 0x72BE5D74 );
+    P( D, E, F, G, H, A, B, C, W[13], 0x80DEB1FE );
+    P( C, D, E, F, G, H, A, B, W[14], 0x9BDC06A7 );
+    P( B, C, D, E, F, G, H, A, W[15], 0xC19BF174 );
+    P( A, B, C, D, E, F, G, H, R(16), 0xE49B69C1 );
+    P( H, A, B, C, D, E, F, G, R(17), 0xEFBE4786 );
+    P( G, H, A, B, C, D, E, F, R(18), 0x0FC19DC6 );
+    P( F, G, H, A, B, C, D, E, R(19), 0x240CA1CC );
+    P( E, F, G, H, A, B, C, D, R(20), 0x2DE92C6F );
+    P( D, E, F, G, H, A, B, C, R(21), 0x4A7484AA );
+    P( C, D, E, F, G, H, A, B, R(22), 0x5CB0A9DC );
+    P( B, C, D, E, F, G, H, A, R(23), 0x76F988DA );
+    P( A, B, C, D, E, F, G, H, R(24), 0x983E5152 );
+    P( H, A, B, C, D, E, F, G, R(25), 0xA831C66D );
+    P( G, H, A, B, C, D, E, F, R(26), 0xB00327C8 );
+    P( F, G, H, A, B, C, D, E, R(27), 0xBF597FC7 );
+    P( E, F, G, H, A, B, C, D, R(28), 0xC6E00BF3 );
+    P( D, E, F, G, H, A, B, C, R(29), 0xD5A79147 );
+    P( C, D, E, F, G, H, A, B, R(30), 0x06CA6351 );
+    P( B, C, D, E, F, G, H, A, R(31), 0x14292967 );
+    P( A, B, C, D, E, F, G, H, R(32), 0x27B70A85 );
+    P( H, A, B, C, D, E, F, G, R(33), 0x2E1B2138 );
+    P( G, H, A, B, C, D, E, F, R(34), 0x4D2C6DFC );
+    P( F, G, H, A, B, C, D, E, R(35), 0x53380D13 );
+    P( E, F, G, H, A, B, C, D, R(36), 0x650A7354 );
+    P( D, E, F, G, H, A, B, C, R(37), 0x766A0ABB );
+    P( C, D, E, F, G, H, A, B, R(38), 0x81C2C92E );
+    P( B, C, D, E, F, G, H, A, R(39), 0x92722C85 );
+    P( A, B, C, D, E, F, G, H, R(40), 0xA2BFE8A1 );
+    P( H, A, B, C, D, E, F, G, R(41), 0xA81A664B );
+    P( G, H, A, B, C, D, E, F, R(42), 0xC24B8B70 );
+    P( F, G, H, A, B, C, D, E, R(43), 0xC76C51A3 );
+    P( E, F, G, H, A, B, C, D, R(44), 0xD192E819 );
+    P( D, E, F, G, H, A, B, C, R(45), 0xD6990624 );
+    P( C, D, E, F, G, H, A, B, R(46), 0xF40E3585 );
+    P( B, C, D, E, F, G, H, A, R(47), 0x106AA070 );
+    P( A, B, C, D, E, F, G, H, R(48), 0x19A4C116 );
+    P( H, A, B, C, D, E, F, G, R(49), 0x1E376C08 );
+    P( G, H, A, B, C, D, E, F, R(50), 0x2748774C );
+    P( F, G, H, A, B, C, D, E, R(51), 0x34B0BCB5 );
+    P( E, F, G, H, A, B, C, D, R(52), 0x391C0CB3 );
+    P( D, E, F, G, H, A, B, C, R(53), 0x4ED8AA4A );
+    P( C, D, E, F, G, H, A, B, R(54), 0x5B9CCA4F );
+    P( B, C, D, E, F, G, H, A, R(55), 0x682E6FF3 );
+    P( A, B, C, D, E, F, G, H, R(56), 0x748F82EE );
+    P( H, A, B, C, D, E, F, G, R(57), 0x78A5636F );
+    P( G, H, A, B, C, D, E, F, R(58), 0x84C87814 );
+    P( F, G, H, A, B, C, D, E, R(59), 0x8CC70208 );
+    P( E, F, G, H, A, B, C, D, R(60), 0x90BEFFFA );
+    P( D, E, F, G, H, A, B, C, R(61), 0xA4506CEB );
+    P( C, D, E, F, G, H, A, B, R(62), 0xBEF9A3F7 );
+    P( B, C, D, E, F, G, H, A, R(63), 0xC67178F2 );
+
+    ctx->state[0] += A;
+    ctx->state[1] += B;
+    ctx->state[2] += C;
+    ctx->state[3] += D;
+    ctx->state[4] += E;
+    ctx->state[5] += F;
+    ctx->state[6] += G;
+    ctx->state[7] += H;
+}
+
+/*
+ * Hardware accelerated compression functions and their runtime dispatch.
+ *
+ * sha256_process_blocks compresses a run of 64 byte blocks with the fastest
+ * implementation the CPU supports. It is picked once at startup: the x86 SHA
+ * extensions, the ARMv8 SHA2 instructions, an SSSE3 message schedule with the
+ * portable rounds, or the portable sha256_process above.
+ */
+
+static const uint32 sha256_k[64] =
+{
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+void sha256_blocks_generic( sha256_context *ctx, uint8 *data, uint32 blocks )
+{
+    while( blocks-- )
+    {
+        sha256_process( ctx, data );
+        data += 64;
+    }
+}
+
+/*
+ * The 64 rounds with an already expanded message schedule W.
+ */
+void sha256_rounds( sha256_context *ctx, uint32 W[64] )
+{
+    uint32 temp1, temp2;
+    uint32 A, B, C, D, E, F, G, H;
+    int t;
+
+    A = ctx->state[0];
+    B = ctx->state[1];
+    C = ctx->state[2];
+    D = ctx->state[3];
+    E = ctx->state[4];
+    F = ctx->state[5];
+    G = ctx->state[6];
+    H = ctx->state[7];
+
+    for( t = 0; t < 64; t += 8 )
+    {
+        P( A, B, C, D, E, F, G, H, W[t    ], sha256_k[t    ] );
+        P( H, A, B, C, D, E, F, G, W[t + 1], sha256_k[t + 1] );
+        P( G, H, A, B, C, D, E, F, W[t + 2], sha256_k[t + 2] );
+        P( F, G, H, A, B, C, D, E, W[t + 3], sha256_k[t + 3] );
+        P( E, F, G, H, A, B, C, D, W[t + 4], sha256_k[t + 4] );
+        P( D, E, F, G, H, A, B, C, W[t + 5], sha256_k[t + 5] );
+        P( C, D, E, F, G, H, A, B, W[t + 6], sha256_k[t + 6] );
+        P( B, C, D, E, F, G, H, A, W[t + 7], sha256_k[t + 7] );
+    }
+
+    ctx->state[0] += A;
+    ctx->state[1] += B;
+    ctx->state[2] += C;
+    ctx->state[3] += D;
+    ctx->state[4] += E;
+    ctx->state[5] += F;
+    ctx->state[6] += G;
+    ctx->state[7] += H;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define SHA256_BSWAP_MASK _mm_set_epi64x( 0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL )
+
+/*
+ * SSSE3 message schedule: the big endian loads are byte shuffles and
+ * W[16..63] are computed four words at a time. sigma1 of the last two
+ * words depends on the first two, so it is added in two halves.
+ */
+#define SHA256_ROTR_V(x,n) _mm_or_si128( _mm_srli_epi32( x, n ), _mm_slli_epi32( x, 32 - (n) ) )
+#define SHA256_S0_V(x) _mm_xor_si128( _mm_xor_si128( SHA256_ROTR_V( x,  7 ), SHA256_ROTR_V( x, 18 ) ), _mm_srli_epi32( x,  3 ) )
+#define SHA256_S1_V(x) _mm_xor_si128( _mm_xor_si128( SHA256_ROTR_V( x, 17 ), SHA256_ROTR_V( x, 19 ) ), _mm_srli_epi32( x, 10 ) )
+
+__attribute__((target("ssse3")))
+void sha256_blocks_ssse3( sha256_context *ctx, uint8 *data, uint32 blocks )
+{
+    uint32 W[64];
+    __m128i w[16], s;
+    int i;
+
+    while( blocks-- )
+    {
+        for( i = 0; i < 4; i++ )
+        {
+            w[i] = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *) ( data + 16 * i ) ), SHA256_BSWAP_MASK );
+            _mm_storeu_si128( (__m128i *) ( W + 4 * i ), w[i] );
+        }
+        for( i = 4; i < 16; i++ )
+        {
+            s = _mm_add_epi32( w[i - 4], SHA256_S0_V( _mm_alignr_epi8( w[i - 3], w[i - 4], 4 ) ) );
+            s = _mm_add_epi32( s, _mm_alignr_epi8( w[i - 1], w[i - 2], 4 ) );
+            s = _mm_add_epi32( s, SHA256_S1_V( _mm_srli_si128( w[i - 1], 8 ) ) );
+            s = _mm_add_epi32( s, SHA256_S1_V( _mm_slli_si128( s, 8 ) ) );
+            w[i] = s;
+            _mm_storeu_si128( (__m128i *) ( W + 4 * i ), s );
+        }
+
+        sha256_rounds( ctx, W );
+        data += 64;
+    }
+}
+
+/*
+ * x86 SHA extensions. The state is kept as ABEF and CDGH, each
+ * sha256rnds2 does two rounds and sha256msg1/sha256msg2 expand the
+ * message four words at a time.
+ */
+__attribute__((target("sha,sse4.1,ssse3")))
+void sha256_blocks_shani( sha256_context *ctx, uint8 *data, uint32 blocks )
+{
+    __m128i state0, state1, msg, tmp, abef, cdgh;
+    __m128i m[4];
+    int i;
+
+    tmp    = _mm_loadu_si128( (const __m128i *) &ctx->state[0] );
+    state1 = _mm_loadu_si128( (const __m128i *) &ctx->state[4] );
+    tmp    = _mm_shuffle_epi32( tmp, 0xB1 );          /* CDAB */
+    state1 = _mm_shuffle_epi32( state1, 0x1B );       /* EFGH */
+    state0 = _mm_alignr_epi8( tmp, state1, 8 );       /* ABEF */
+    state1 = _mm_blend_epi16( state1, tmp, 0xF0 );    /* CDGH */
+
+    while( blocks-- )
+    {
+        abef = state0;
+        cdgh = state1;
+
+        for( i = 0; i < 16; i++ )
+        {
+            if( i < 4 )
+                m[i] = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *) ( data + 16 * i ) ), SHA256_BSWAP_MASK );
+            else
+            {
+                tmp = _mm_sha256msg1_epu32( m[i & 3], m[(i - 3) & 3] );
+                tmp = _mm_add_epi32( tmp, _mm_alignr_epi8( m[(i - 1) & 3], m[(i - 2) & 3], 4 ) );
+                m[i & 3] = _mm_sha256msg2_epu32( tmp, m[(i - 1) & 3] );
+            }
+
+            msg    = _mm_add_epi32( m[i & 3], _mm_loadu_si128( (const __m128i *) &sha256_k[4 * i] ) );
+            state1 = _mm_sha256rnds2_epu32( state1, state0, msg );
+            msg    = _mm_shuffle_epi32( msg, 0x0E );
+            state0 = _mm_sha256rnds2_epu32( state0, state1, msg );
+        }
+
+        state0 = _mm_add_epi32( state0, abef );
+        state1 = _mm_add_epi32( state1, cdgh );
+        data += 64;
+    }
+
+    tmp    = _mm_shuffle_epi32( state0, 0x1B );       /* FEBA */
+    state1 = _mm_shuffle_epi32( state1, 0xB1 );       /* DCHG */
+    state0 = _mm_blend_epi16( tmp, state1, 0xF0 );    /* DCBA */
+    state1 = _mm_alignr_epi8( state1, tmp, 8 );       /* HGFE */
+
+    _mm_storeu_si128( (__m128i *) &ctx->state[0], state0 );
+    _mm_storeu_si128( (__m128i *) &ctx->state[4], state1 );
+}
+
+static sha256_blocks_fn sha256_select_blocks( void )
+{
+    unsigned int a, b, c, d;
+    int ssse3, sse41;
+
+    if( !__get_cpuid( 1, &a, &b, &c, &d ) )
+        return sha256_blocks_generic;
+    ssse3 = ( c >> 9 ) & 1;
+    sse41 = ( c >> 19 ) & 1;
+
+    if( ssse3 && sse41 && __get_cpuid_count( 7, 0, &a, &b, &c, &d ) && ( ( b >> 29 ) & 1 ) )
+        return sha256_blocks_shani;
+    if( ssse3 )
+        return sha256_blocks_ssse3;
+    return sha256_blocks_generic;
+}
+
+#elif defined(__aarch64__)
+
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+
+/*
+ * ARMv8 SHA2 instructions. sha256h/sha256h2 do four rounds on ABCD and
+ * EFGH, sha256su0/sha256su1 expand the message four words at a time.
+ */
+__attribute__((target("+crypto")))
+void sha256_blocks_armv8( sha256_context *ctx, uint8 *data, uint32 blocks )
+{
+    uint32x4_t state0, state1, abcd, efgh, tmp, abcd_prev;
+    uint32x4_t m[4];
+    int i;
+
+    state0 = vld1q_u32( &ctx->state[0] );
+    state1 = vld1q_u32( &ctx->state[4] );
+
+    while( blocks-- )
+    {
+        abcd = state0;
+        efgh = state1;
+
+        for( i = 0; i < 16; i++ )
+        {
+            if( i < 4 )
+                m[i] = vreinterpretq_u32_u8( vrev32q_u8( vld1q_u8( data + 16 * i ) ) );
+            else
+                m[i & 3] = vsha256su1q_u32( vsha256su0q_u32( m[i & 3], m[(i - 3) & 3] ), m[(i - 2) & 3], m[(i - 1) & 3] );
+
+            tmp = vaddq_u32( m[i & 3], vld1q_u32( &sha256_k[4 * i] ) );
+            abcd_prev = abcd;
+            abcd = vsha256hq_u32( abcd, efgh, tmp );
+            efgh = vsha256h2q_u32( efgh, abcd_prev, tmp );
+        }
+
+        state0 = vaddq_u32( state0, abcd );
+        state1 = vaddq_u32( state1, efgh );
+        data += 64;
+    }
+
+    vst1q_u32( &ctx->state[0], state0 );
+    vst1q_u32( &ctx->state[4], state1 );
+}
+
+static sha256_blocks_fn sha256_select_blocks( void )
+{
+    if( getauxval( AT_HWCAP ) & HWCAP_SHA2 )
+        return sha256_blocks_armv8;
+    return sha256_blocks_generic;
+}
+
+#else
+
+static sha256_blocks_fn sha256_select_blocks( void )
+{
+    return sha256_blocks_generic;
+}
+
+#endif
+
+static sha256_blocks_fn sha256_process_blocks = sha256_blocks_generic;
+
+__attribute__((constructor))
+static void sha256_init_dispatch( void )
+{
+    sha256_process_blocks = sha256_select_blocks();
+}
+
+void sha256_update( sha256_context *ctx, uint8 *input, uint32 length )
+{
+    uint32 left, fill;
+
+    if( ! length ) return;
+
+    left = ctx->total[0] & 0x3F;
+    fill = 64 - left;
+
+    ctx->total[0] += length;
+    ctx->total[0] &= 0xFFFFFFFF;
+
+    if( ctx->total[0] < length )
+        ctx->total[1]++;
+
+    if( left && length >= fill )
+    {
+        memcpy( (void *) (ctx->buffer + left),
+			   (void *) input, fill );
+        sha256_process_blocks( ctx, ctx->buffer, 1 );
+        length -= fill;
+        input  += fill;
+        left = 0;
+    }
+
+    if( length >= 64 )
+    {
+        sha256_process_blocks( ctx, input, length / 64 );
+        input  += length & ~0x3F;
+        length &= 0x3F;
+    }
+
+    if( length )
+    {
+        memcpy( (void *) (ctx->buffer + left),
+			   (void *) input, length );
+    }
+}
+
+static uint8 sha256_padding[64] =
+{
+	0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+void sha256_finish( sha256_context *ctx, uint8 digest[32] )
+{
+    uint32 last, padn;
+    uint32 high, low;
+    uint8 msglen[8];
+
+    high = ( ctx->total[0] >> 29 )
+	| ( ctx->total[1] <<  3 );
+    low  = ( ctx->total[0] <<  3 );
+
+    PUT_UINT32( high, msglen, 0 );
+    PUT_UINT32( low,  msglen, 4 );
+
+    last = ctx->total[0] & 0x3F;
+    padn = ( last < 56 ) ? ( 56 - last ) : ( 120 - last );
+
+    sha256_update( ctx, sha256_padding, padn );
+    sha256_update( ctx, msglen, 8 );
+
+    PUT_UINT32( ctx->state[0], digest,  0 );
+    PUT_UINT32( ctx->state[1], digest,  4 );
+    PUT_UINT32( ctx->state[2], digest,  8 );
+    PUT_UINT32( ctx->state[3], digest, 12 );
+    PUT_UINT32( ctx->state[4], digest, 16 );
+    PUT_UINT32( ctx->state[5], digest, 20 );
+    PUT_UINT32( ctx->state[6], digest, 24 );
+    PUT_UINT32( ctx->state[7], digest, 28 );
+}
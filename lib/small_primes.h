@@ -0,0 +1,29 @@
+/**
+ * @file
+ * @brief Table of the small odd primes.
+ *
+ * The odd primes below SMALL_PRIME_LIMIT, used to sieve the prime candidates in the key generation. The table is
+ * generated once and compiled in, so it is not computed at run time. It was generated with:
+ * @code
+ * python3 -c "N=8192;print([p for p in range(3,N) if all(p%d for d in range(2,int(p**.5)+1))])"
+ * @endcode
+ */
+
+#ifndef SMALL_PRIMES_H_
+#define SMALL_PRIMES_H_
+
+/**
+ * The primes in the table are below this number.
+ */
+#define SMALL_PRIME_LIMIT 8192
+/**
+ * Number of primes in the table.
+ */
+#define SMALL_PRIME_COUNT 1027
+
+/**
+ * The odd primes below SMALL_PRIME_LIMIT in increasing order.
+ */
+extern const unsigned int small_primes[SMALL_PRIME_COUNT];
+
+#endif /* SMALL_PRIMES_H_ */
@@ -0,0 +1,362 @@
+/**
+ * @file
+ * @brief Streaming encryption pipeline.
+ */
+
+#include "stream_opts.h"
+
+/**
+ *
+ * @param q The queue
+ * @param cap Capacity of the queue
+ *
+ * @brief Initializes an empty queue.
+ */
+void chunk_queue_init(chunk_queue* q,size_t cap){
+	q->items = (stream_chunk**)malloc(cap*sizeof(stream_chunk*));
+	q->cap = cap;
+	q->head = 0;
+	q->count = 0;
+	q->closed = 0;
+	pthread_mutex_init(&q->lock,NULL);
+	pthread_cond_init(&q->not_empty,NULL);
+	pthread_cond_init(&q->not_full,NULL);
+}
+/**
+ *
+ * @param q The queue
+ *
+ * @brief Frees the queue.
+ */
+void chunk_queue_destroy(chunk_queue* q){
+	free(q->items);
+	pthread_mutex_destroy(&q->lock);
+	pthread_cond_destroy(&q->not_empty);
+	pthread_cond_destroy(&q->not_full);
+}
+/**
+ *
+ * @param q The queue
+ * @param c The chunk
+ *
+ * @brief Puts the chunk at the end of the queue, waits while the queue is full.
+ */
+void chunk_queue_push(chunk_queue* q,stream_chunk* c){
+	pthread_mutex_lock(&q->lock);
+	while(q->count == q->cap)
+		pthread_cond_wait(&q->not_full,&q->lock);
+	q->items[(q->head + q->count) % q->cap] = c;
+	q->count++;
+	pthread_cond_signal(&q->not_empty);
+	pthread_mutex_unlock(&q->lock);
+}
+/**
+ *
+ * @param q The queue
+ * @return The first chunk, NULL if the queue is closed and empty
+ *
+ * @brief Takes the first chunk of the queue, waits while the queue is empty.
+ */
+stream_chunk* chunk_queue_pop(chunk_queue* q){
+	stream_chunk* c = NULL;
+
+	pthread_mutex_lock(&q->lock);
+	while(q->count == 0 && !q->closed)
+		pthread_cond_wait(&q->not_empty,&q->lock);
+	if(q->count > 0){
+		c = q->items[q->head];
+		q->head = (q->head + 1) % q->cap;
+		q->count--;
+		pthread_cond_signal(&q->not_full);
+	}
+	pthread_mutex_unlock(&q->lock);
+	return c;
+}
+/**
+ *
+ * @param q The queue
+ *
+ * @brief Closes the queue, the stages waiting on it wake up when it is empty.
+ */
+void chunk_queue_close(chunk_queue* q){
+	pthread_mutex_lock(&q->lock);
+	q->closed = 1;
+	pthread_cond_broadcast(&q->not_empty);
+	pthread_mutex_unlock(&q->lock);
+}
+/**
+ *
+ * @param fd File descriptor
+ * @param buf Buffer
+ * @param size Bytes to read
+ * @return Bytes read, less than size only at the end of the file
+ *
+ * @brief Reads until the buffer is full or the file ends.
+ */
+size_t read_full(int fd,char* buf,size_t size){
+	size_t done = 0;
+	ssize_t r;
+
+	while(done < size){
+		r = read(fd,buf+done,size-done);
+		if(r < 0 && errno == EINTR)
+			continue;
+		if(r < 0){
+			fprintf(stderr,"read failed. (read_full)\n");
+			exit(0);
+		}
+		if(r == 0)
+			break;
+		done += r;
+	}
+	return done;
+}
+/**
+ *
+ * @param fd File descriptor
+ * @param buf Buffer
+ * @param size Bytes to write
+ *
+ * @brief Writes the whole buffer.
+ */
+void write_full(int fd,const void* buf,size_t size){
+	const char* p = (const char*)buf;
+	ssize_t w;
+
+	while(size > 0){
+		w = write(fd,p,size);
+		if(w < 0 && errno == EINTR)
+			continue;
+		if(w < 0){
+			fprintf(stderr,"write failed. (write_full)\n");
+			exit(0);
+		}
+		p += w;
+		size -= w;
+	}
+}
+/**
+ *
+ * @param arg The job
+ * @return NULL
+ *
+ * @brief Reader stage, fills the free chunks with the prefix, the plain text and the suffix.
+ *
+ * When the job has a signing key, each chunk is added to the hash as it is read, and the suffix is the signature
+ * created from the final digest, so the file is read only once.
+ */
+void* stream_reader(void* arg){
+	stream_job* job = (stream_job*)arg;
+	size_t chunk_bytes = STREAM_CHUNK_BLOCKS*job->block_size;
+	size_t suffix_done = 0,seq = 0,n;
+	unsigned char sum[32];
+	int file_done = 0;
+	stream_chunk* c;
+
+	while(suffix_done < job->suffix_size || !file_done){
+		c = chunk_queue_pop(&job->free_q);
+		c->size = 0;
+		if(seq == 0 && job->prefix_size > 0){// the prefix comes before the file
+			memcpy(c->in,job->prefix,job->prefix_size);
+			c->size = job->prefix_size;
+		}
+		if(!file_done){
+			n = read_full(job->in_fd,c->in+c->size,chunk_bytes-c->size);
+			file_done = n < chunk_bytes-c->size;
+			if(job->sign_key != NULL){// hash the chunk while it is in the cache
+				sha256_update_buffer(&job->hash,c->in+c->size,n);
+				if(file_done){
+					sha256_finish(&job->hash,sum);
+					job->suffix = job->sign(sum,job->sign_key,&job->suffix_size);
+				}
+			}
+			c->size += n;
+		}
+		if(file_done){// the suffix comes after the file
+			n = job->suffix_size - suffix_done < chunk_bytes - c->size ? job->suffix_size - suffix_done : chunk_bytes - c->size;
+			memcpy(c->in+c->size,job->suffix+suffix_done,n);
+			c->size += n;
+			suffix_done += n;
+		}
+		if(c->size == 0){// nothing left
+			chunk_queue_push(&job->free_q,c);
+			break;
+		}
+		c->seq = seq++;
+		c->count = (c->size + job->block_size - 1) / job->block_size;
+		job->count += c->count;
+		chunk_queue_push(&job->work_q,c);
+	}
+	chunk_queue_close(&job->work_q);
+	return NULL;
+}
+/**
+ *
+ * @param arg The job
+ * @return NULL
+ *
+ * @brief Worker stage, encrypts the blocks of the chunks in the packed block mode.
+ */
+void* stream_worker(void* arg){
+	stream_job* job = (stream_job*)arg;
+	block_job bj;
+	stream_chunk* c;
+	mpz_t enc_res;
+	size_t i;
+
+	mpz_init2(enc_res,(mpz_size(job->key->n)+1)*GMP_NUMB_BITS); /// allocated once for all the blocks of the worker
+	bj.key = job->key;
+	bj.block_size = job->block_size;
+
+	while((c = chunk_queue_pop(&job->work_q)) != NULL){
+		bj.in = c->in;
+		bj.in_size = c->size;
+		for(i = 0; i < c->count; i++){
+			encrypt_packed_block(enc_res,&bj,i);
+			export_fixed(c->out+(i*job->width),job->width,enc_res);
+		}
+		chunk_queue_push(&job->done_q,c);
+	}
+
+	mpz_clear(enc_res);
+	return NULL;
+}
+/**
+ *
+ * @param arg The job
+ * @return NULL
+ *
+ * @brief Writer stage, writes the encrypted chunks in the order of the message.
+ *
+ * The chunks can come out of order from the workers. They wait in the place of their order until the chunks before them
+ * are written. There are only nchunks chunks, so their orders can not collide.
+ */
+void* stream_writer(void* arg){
+	stream_job* job = (stream_job*)arg;
+	stream_chunk** pending = (stream_chunk**)calloc(job->nchunks,sizeof(stream_chunk*));
+	size_t next = 0;
+	stream_chunk* c;
+
+	while((c = chunk_queue_pop(&job->done_q)) != NULL){
+		pending[c->seq % job->nchunks] = c;
+		while((c = pending[next % job->nchunks]) != NULL && c->seq == next){
+			write_full(job->out_fd,c->out,c->count*job->width);
+			pending[next % job->nchunks] = NULL;
+			next++;
+			chunk_queue_push(&job->free_q,c);
+		}
+	}
+
+	free(pending);
+	return NULL;
+}
+/**
+ *
+ * @param job The job, its input, output and keys are set
+ *
+ * @brief Runs the reader, the workers and the writer of the pipeline until the whole input is written.
+ *
+ * 2 x threads + 2 chunks are in the memory at any time. The number of workers is the number of threads of the block engine.
+ */
+void run_stream_job(stream_job* job){
+	pthread_t reader,writer,workers[BLOCK_ENGINE_MAX_THREADS];
+	stream_chunk* chunks;
+	size_t i;
+	int t;
+
+	job->block_size = packed_block_size(job->key);
+	job->width = (mpz_sizeinbase(job->key->n,BINARY) + 7) / 8;
+	job->nchunks = 2*block_engine_threads + 2;
+	job->count = 0;
+
+	chunk_queue_init(&job->free_q,job->nchunks);
+	chunk_queue_init(&job->work_q,job->nchunks);
+	chunk_queue_init(&job->done_q,job->nchunks);
+	chunks = (stream_chunk*)malloc(job->nchunks*sizeof(stream_chunk));
+	for(i = 0; i < job->nchunks; i++){
+		chunks[i].in = (char*)malloc(STREAM_CHUNK_BLOCKS*job->block_size*sizeof(char));
+		chunks[i].out = (unsigned char*)malloc(STREAM_CHUNK_BLOCKS*job->width*sizeof(unsigned char));
+		chunk_queue_push(&job->free_q,&chunks[i]);
+	}
+	get_rsa_key_ctx(job->key); /// build the context before the workers share it
+
+	if(pthread_create(&reader,NULL,stream_reader,job) != 0 || pthread_create(&writer,NULL,stream_writer,job) != 0){
+		fprintf(stderr,"pthread_create failed (run_stream_job)\n");
+		exit(0);
+	}
+	for(t = 0; t < block_engine_threads; t++){
+		if(pthread_create(&workers[t],NULL,stream_worker,job) != 0){
+			fprintf(stderr,"pthread_create failed (run_stream_job)\n");
+			exit(0);
+		}
+	}
+
+	pthread_join(reader,NULL);
+	for(t = 0; t < block_engine_threads; t++)
+		pthread_join(workers[t],NULL);
+	chunk_queue_close(&job->done_q);
+	pthread_join(writer,NULL);
+
+	for(i = 0; i < job->nchunks; i++){
+		free(chunks[i].in);
+		free(chunks[i].out);
+	}
+	free(chunks);
+	chunk_queue_destroy(&job->free_q);
+	chunk_queue_destroy(&job->work_q);
+	chunk_queue_destroy(&job->done_q);
+}
+/**
+ *
+ * @param in_fd File descriptor of the plain text
+ * @param in_size Size of the plain text, not used when pr_key is set
+ * @param prefix Data put before the plain text, at most a chunk, can be NULL
+ * @param prefix_size Size of the prefix
+ * @param suffix Data appended after the plain text, not used when pr_key is set
+ * @param suffix_size Size of the suffix
+ * @param sign Creates the suffix from the digest of the plain text when pr_key is set
+ * @param pr_key Sender's private key, if set the suffix is created by sign
+ * @param key Receiver's public key
+ * @param out_fd File descriptor the binary ciphered data is written to, a regular file when pr_key is set
+ *
+ * @brief Encrypts the prefix, the plain text and the suffix into the binary ciphered file format with the streaming pipeline.
+ *
+ * The output is the same with pub_enc_bin on the concatenation of the prefix, the plain text and the suffix, but only
+ * a few chunks are in the memory at any time (see run_stream_job). Without pr_key the block count is known from the
+ * sizes, so the header is written first. With pr_key the reader stage hashes the chunks as it reads them and creates
+ * the suffix at the end of the file. The block count is only known then, so the header is written again at the start
+ * of the file when the pipeline is done.
+ */
+void stream_enc_bin_framed(int in_fd,size_t in_size,char* prefix,size_t prefix_size,char* suffix,size_t suffix_size,
+		suffix_func sign,rsa_key* pr_key,rsa_key* key,int out_fd){
+	unsigned char header[CONTAINER_HEADER_SIZE];
+	size_t width = (mpz_sizeinbase(key->n,BINARY) + 7) / 8;
+	size_t block_size = packed_block_size(key);
+	stream_job job;
+
+	job.in_fd = in_fd;
+	job.prefix = prefix;
+	job.prefix_size = prefix_size;
+	job.suffix = pr_key != NULL ? NULL : suffix;
+	job.suffix_size = pr_key != NULL ? 0 : suffix_size;
+	job.out_fd = out_fd;
+	job.key = key;
+	job.sign_key = pr_key;
+	job.sign = sign;
+	sha256_starts(&job.hash);
+
+	put_container_header(header,CONTAINER_MODE_PACKED,width,
+			pr_key != NULL ? 0 : (prefix_size + in_size + suffix_size + block_size - 1) / block_size);
+	write_full(out_fd,header,CONTAINER_HEADER_SIZE);
+
+	run_stream_job(&job);
+
+	if(pr_key != NULL){
+		put_container_header(header,CONTAINER_MODE_PACKED,width,job.count);
+		if(pwrite(out_fd,header,CONTAINER_HEADER_SIZE,0) != CONTAINER_HEADER_SIZE){
+			fprintf(stderr,"pwrite failed. (stream_enc_bin_framed)\n");
+			exit(0);
+		}
+		free(job.suffix);
+	}
+}
@@ -0,0 +1,93 @@
+/**
+ * @file
+ * @brief Streaming encryption pipeline with bounded memory.
+ *
+ * The message is encrypted in three stages connected with bounded queues. The reader stage reads the plain text
+ * into chunks, a pool of workers encrypts the chunks and the writer stage writes the encrypted chunks in order.
+ * There is a fixed number of chunks which go around the stages, so the memory use does not depend on the size of the
+ * message, and the disk reads and writes are done while the workers are busy with the exponentiations.
+ */
+
+#ifndef STREAM_OPTS_H_
+#define STREAM_OPTS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "block_engine.h"
+#include "general_opts.h"
+
+/**
+ * Number of blocks in a chunk.
+ */
+#define STREAM_CHUNK_BLOCKS 64
+
+/**
+ * @struct STREAM_CHUNK
+ * @brief STREAM_CHUNK is a piece of the message with its place in the message.
+ */
+typedef struct STREAM_CHUNK {
+	size_t seq; // order of the chunk in the message
+	size_t size; // bytes of plain text in the chunk
+	size_t count; // number of blocks in the chunk
+	char* in; // plain text, STREAM_CHUNK_BLOCKS blocks
+	unsigned char* out; // encrypted blocks
+}stream_chunk;
+
+/**
+ * @struct CHUNK_QUEUE
+ * @brief CHUNK_QUEUE is a bounded queue of chunks between two stages.
+ */
+typedef struct CHUNK_QUEUE {
+	stream_chunk** items; // ring buffer of chunks
+	size_t cap; // capacity of the queue
+	size_t head; // index of the first chunk
+	size_t count; // number of chunks in the queue
+	int closed; // set when no more chunks will be pushed
+	pthread_mutex_t lock;
+	pthread_cond_t not_empty;
+	pthread_cond_t not_full;
+}chunk_queue;
+
+/**
+ * @struct STREAM_JOB
+ * @brief STREAM_JOB is the state shared by the stages of the pipeline.
+ */
+typedef struct STREAM_JOB {
+	int in_fd; // plain text is read from here
+	char* prefix; // data put before the content of in_fd, it fits into a chunk
+	size_t prefix_size; // size of the prefix
+	char* suffix; // data appended after the content of in_fd
+	size_t suffix_size; // size of the suffix
+	int out_fd; // encrypted blocks are written here
+	rsa_key* key; // key used for encryption
+	rsa_key* sign_key; // if set, the suffix is created by sign from the digest of the content of in_fd
+	suffix_func sign; // creates the suffix, like create_envelope_suffix
+	sha256_context hash; // hash of the content of in_fd, when sign_key is set
+	size_t count; // number of blocks read
+	size_t block_size; // plain text bytes in a block
+	size_t width; // bytes of an encrypted block
+	size_t nchunks; // number of chunks going around
+	chunk_queue free_q; // empty chunks waiting for the reader
+	chunk_queue work_q; // full chunks waiting for a worker
+	chunk_queue done_q; // encrypted chunks waiting for the writer
+}stream_job;
+
+void chunk_queue_init(chunk_queue* q,size_t cap);
+void chunk_queue_destroy(chunk_queue* q);
+void chunk_queue_push(chunk_queue* q,stream_chunk* c);
+stream_chunk* chunk_queue_pop(chunk_queue* q);
+void chunk_queue_close(chunk_queue* q);
+size_t read_full(int fd,char* buf,size_t size);
+void write_full(int fd,const void* buf,size_t size);
+void* stream_reader(void* arg);
+void* stream_worker(void* arg);
+void* stream_writer(void* arg);
+void run_stream_job(stream_job* job);
+void stream_enc_bin_framed(int in_fd,size_t in_size,char* prefix,size_t prefix_size,char* suffix,size_t suffix_size,
+		suffix_func sign,rsa_key* pr_key,rsa_key* key,int out_fd);
+
+#endif /* STREAM_OPTS_H_ */
@@ -7,34 +7,143 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
-#include "../lib/blumblumshub.h"
+#include <string.h>
 #include "../lib/math_opts.h"
 #include "../lib/rsa_opts.h"
 #include "../lib/general_opts.h"
+#include "../lib/stream_opts.h"
+#include "../lib/merkle_opts.h"
 #include "../lib/bit_opts.h"
+#include "../lib/envelope.h"
+
+/**
+ *
+ * @param m Message
+ * @param m_size Size of the message
+ * @param s_pr Sender's private key
+ * @param suffix_size Size of the returned data
+ * @return The signature and the fingerprint fields of the envelope in the Merkle mode
+ *
+ * @brief Signs the message with the root of its Merkle tree, the chunks are hashed on the worker threads.
+ */
+char* create_merkle_suffix(char* m,size_t m_size,rsa_key* s_pr,size_t* suffix_size){
+	unsigned char root[32];
+
+	create_merkle_root(m,m_size,MERKLE_CHUNK_SIZE,MERKLE_ARITY,root);
+	return create_envelope_suffix(root,s_pr,suffix_size);
+}
+/**
+ *
+ * @param prefix Output, ENVELOPE_PREFIX_SIZE bytes
+ * @param m_size Size of the message
+ * @param merkle Sign in the Merkle mode
+ *
+ * @brief Writes the envelope header and the length of the message, they are encrypted before the message.
+ */
+void put_message_prefix(unsigned char* prefix,size_t m_size,int merkle){
+	if(merkle)
+		put_envelope_prefix(prefix,ENVELOPE_SIG_MERKLE,MERKLE_CHUNK_SIZE,MERKLE_ARITY,m_size);
+	else
+		put_envelope_prefix(prefix,ENVELOPE_SIG_HASH,0,0,m_size);
+}
+/**
+ *
+ * @param filename Input message file
+ * @param s_pr Sender's private key
+ * @param r_pu Receiver's public key
+ * @param merkle Sign in the Merkle mode
+ *
+ * @brief Creates the message to send with the streaming pipeline.
+ *
+ * The file is read once: the pipeline hashes each piece as it reads it and encrypts it, and the signature is
+ * encrypted after the file. Neither the message nor the encrypted message is kept in the memory as a whole.
+ * In the Merkle mode the tree is built first over the mapped file, in parallel, and its signature is given
+ * to the pipeline as the suffix. The message is put in an envelope (see envelope.h).
+ */
+void send_message_stream(char* filename,rsa_key* s_pr,rsa_key* r_pu,int merkle){
+	unsigned char prefix[ENVELOPE_PREFIX_SIZE];
+	mapped_file *id;
+	char* suffix;
+	size_t suffix_size;
+	struct stat st;
+	int in_fd,out_fd;
+
+	if((in_fd = open(filename,O_RDONLY)) < 0){
+		fprintf(stderr,"open Failed (send_message_stream)");
+		exit(0);
+	}
+	if((out_fd = open("message_to_send.txt",O_WRONLY|O_CREAT|O_TRUNC,0644)) < 0){
+		fprintf(stderr,"open Failed (send_message_stream)");
+		exit(0);
+	}
+
+	if(fstat(in_fd,&st) < 0){
+		fprintf(stderr,"fstat Failed (send_message_stream)");
+		exit(0);
+	}
+	put_message_prefix(prefix,st.st_size,merkle);
+
+	if(merkle){
+		id = map_file(filename);
+		suffix = create_merkle_suffix(id->data,id->size,s_pr,&suffix_size);
+		stream_enc_bin_framed(in_fd,id->size,(char*)prefix,ENVELOPE_PREFIX_SIZE,suffix,suffix_size,NULL,NULL,r_pu,out_fd);
+		unmap_file(id);
+		free(suffix);
+	}
+	else{
+		stream_enc_bin_framed(in_fd,st.st_size,(char*)prefix,ENVELOPE_PREFIX_SIZE,NULL,0,create_envelope_suffix,s_pr,r_pu,out_fd);
+	}
+
+	close(in_fd);
+	close(out_fd);
+}
 
 int main(int argc,char** argv) {
 	rsa_key *r_pu, *s_pr;
-	char *id,*ds,*sender_msg,*id_ds_concat;
+	mapped_file *id;
+	unsigned char prefix[ENVELOPE_PREFIX_SIZE];
+	char *sender_msg;
+	size_t sender_msg_size;
+	char *suffix = NULL;
+	size_t suffix_size = 0;
+	int stream,hybrid,merkle;
 
-	if(argc != 4){
-		fprintf(stderr,"Usage : ./send_message input_message sender's_private_key receiver's_public_key\n");
+	parse_threads_option(&argc,argv);
+	stream = parse_flag_option(&argc,argv,"--stream");
+	hybrid = parse_flag_option(&argc,argv,"--hybrid");
+	merkle = parse_flag_option(&argc,argv,"--merkle");
+	if(argc != 4 || (stream && hybrid)){
+		fprintf(stderr,"Usage : ./send_message [--threads N] [--stream | --hybrid] [--merkle] input_message sender's_private_key receiver's_public_key\n");
 		exit(0);
 	}
 
-	id = read_file_to_string(argv[1]);
 	s_pr = get_key_from_file(argv[2]);
 	r_pu = get_key_from_file(argv[3]);
 
-	ds = create_ds(id,s_pr);
-	id_ds_concat = concatenate(id,ds);
+	if(stream){
+		send_message_stream(argv[1],s_pr,r_pu,merkle);
+		return EXIT_SUCCESS;
+	}
+
+	id = map_file(argv[1]);
+	put_message_prefix(prefix,id->size,merkle);
 
-	sender_msg = pub_enc(id_ds_concat,r_pu);
-	write_string_to_file("message_to_send.txt",sender_msg);
+	if(merkle){// the tree is signed first, then the envelope is encrypted
+		suffix = create_merkle_suffix(id->data,id->size,s_pr,&suffix_size);
+		if(hybrid)
+			sender_msg = pub_enc_hybrid_framed((char*)prefix,ENVELOPE_PREFIX_SIZE,id->data,id->size,suffix,suffix_size,NULL,NULL,r_pu,&sender_msg_size);
+		else
+			sender_msg = pub_enc_bin_framed((char*)prefix,ENVELOPE_PREFIX_SIZE,id->data,id->size,suffix,suffix_size,NULL,NULL,r_pu,&sender_msg_size);
+	}
+	// the message is hashed and encrypted in the same pass, the signature and the fingerprint are encrypted after it
+	else if(hybrid)
+		sender_msg = pub_enc_hybrid_framed((char*)prefix,ENVELOPE_PREFIX_SIZE,id->data,id->size,NULL,0,create_envelope_suffix,s_pr,r_pu,&sender_msg_size);
+	else
+		sender_msg = pub_enc_bin_framed((char*)prefix,ENVELOPE_PREFIX_SIZE,id->data,id->size,NULL,0,create_envelope_suffix,s_pr,r_pu,&sender_msg_size);
+	write_buffer_to_file("message_to_send.txt",sender_msg,sender_msg_size);
 
-	free(id);
-	free(ds);
+	unmap_file(id);
 	free(sender_msg);
-	free(id_ds_concat);
+	free(suffix);
 	return EXIT_SUCCESS;
 }
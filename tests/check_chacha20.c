@@ -0,0 +1,158 @@
+/**
+ * @file
+ * @brief Checks the ChaCha20 cipher against RFC 8439 and its own block function.
+ *
+ * chacha20_xor takes the key stream from the rest of the last block, from chacha20_block4 for 256 byte runs and
+ * from chacha20_block for the other whole and partial blocks, so the same message is xored by different paths
+ * depending on how it is cut. The check encrypts the RFC 8439 section 2.4.2 test vector, then compares random
+ * messages encrypted in one call and in many odd-sized calls with a key stream built by chacha20_block alone.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../lib/chacha20.h"
+
+/**
+ * Longest random message, several runs of chacha20_block4.
+ */
+#define CHECK_CHACHA20_MAX_LENGTH 2000
+/**
+ * Random messages, each one is cut into pieces of different odd sizes.
+ */
+#define CHECK_CHACHA20_TRIES 500
+
+/**
+ * RFC 8439 section 2.4.2 plain text.
+ */
+const char* rfc_plain = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, "
+		"sunscreen would be it.";
+/**
+ * RFC 8439 section 2.4.2 cipher text, with key 00 01 .. 1f, nonce 00 00 00 00 00 00 00 4a 00 00 00 00 and counter 1.
+ */
+const unsigned char rfc_cipher[114] = {
+	0x6e,0x2e,0x35,0x9a,0x25,0x68,0xf9,0x80,0x41,0xba,0x07,0x28,0xdd,0x0d,0x69,0x81,
+	0xe9,0x7e,0x7a,0xec,0x1d,0x43,0x60,0xc2,0x0a,0x27,0xaf,0xcc,0xfd,0x9f,0xae,0x0b,
+	0xf9,0x1b,0x65,0xc5,0x52,0x47,0x33,0xab,0x8f,0x59,0x3d,0xab,0xcd,0x62,0xb3,0x57,
+	0x16,0x39,0xd6,0x24,0xe6,0x51,0x52,0xab,0x8f,0x53,0x0c,0x35,0x9f,0x08,0x61,0xd8,
+	0x07,0xca,0x0d,0xbf,0x50,0x0d,0x6a,0x61,0x56,0xa3,0x8e,0x08,0x8a,0x22,0xb6,0x5e,
+	0x52,0xbc,0x51,0x4d,0x16,0xcc,0xf8,0x06,0x81,0x8c,0xe9,0x1a,0xb7,0x79,0x37,0x36,
+	0x5a,0xf9,0x0b,0xbf,0x74,0xa3,0x5b,0xe6,0xb4,0x0b,0x8e,0xed,0xf2,0x78,0x5e,0x42,
+	0x87,0x4d
+};
+
+/**
+ *
+ * @return Number of the wrong bytes
+ *
+ * @brief Encrypts the RFC 8439 section 2.4.2 plain text and decrypts it back.
+ */
+int check_rfc_vector(void){
+	unsigned char key[CHACHA20_KEY_SIZE],nonce[CHACHA20_NONCE_SIZE],out[114];
+	size_t len = strlen(rfc_plain);
+	chacha20_ctx ctx;
+	int bad = 0,i;
+
+	for(i = 0; i < CHACHA20_KEY_SIZE; i++)
+		key[i] = (unsigned char)i;
+	memset(nonce,0,sizeof(nonce));
+	nonce[7] = 0x4a;
+
+	if(len != sizeof(rfc_cipher))
+		return 1;
+	chacha20_init(&ctx,key,nonce,1);
+	chacha20_xor(&ctx,(const unsigned char*)rfc_plain,out,len);
+	for(i = 0; i < (int)len; i++)
+		bad += out[i] != rfc_cipher[i];
+
+	chacha20_init(&ctx,key,nonce,1);
+	chacha20_xor(&ctx,out,out,len);
+	bad += memcmp(out,rfc_plain,len) != 0;
+	printf("RFC 8439 2.4.2: %d wrong bytes\n",bad);
+	return bad;
+}
+/**
+ *
+ * @param key The key
+ * @param nonce The nonce
+ * @param counter First block counter
+ * @param in Input data
+ * @param out Output data
+ * @param len Size of the data
+ *
+ * @brief Xors the data with a key stream computed one block at a time by chacha20_block.
+ */
+void reference_xor(const unsigned char* key,const unsigned char* nonce,uint32_t counter,const unsigned char* in,
+		unsigned char* out,size_t len){
+	unsigned char ks[CHACHA20_BLOCK_SIZE];
+	chacha20_ctx ctx;
+	size_t i;
+
+	chacha20_init(&ctx,key,nonce,counter);
+	for(i = 0; i < len; i++){
+		if(i % CHACHA20_BLOCK_SIZE == 0)
+			chacha20_block(&ctx,ks);
+		out[i] = in[i] ^ ks[i % CHACHA20_BLOCK_SIZE];
+	}
+}
+/**
+ *
+ * @return Number of the mismatches
+ *
+ * @brief Compares one call and many odd-sized calls of chacha20_xor with the reference on random messages.
+ */
+long check_pieces(void){
+	unsigned char key[CHACHA20_KEY_SIZE],nonce[CHACHA20_NONCE_SIZE];
+	unsigned char in[CHECK_CHACHA20_MAX_LENGTH],ref[CHECK_CHACHA20_MAX_LENGTH];
+	unsigned char one[CHECK_CHACHA20_MAX_LENGTH],cut[CHECK_CHACHA20_MAX_LENGTH];
+	chacha20_ctx ctx;
+	size_t len,done,piece;
+	uint32_t counter;
+	long bad = 0;
+	int t,i;
+
+	srand(1);
+	for(t = 0; t < CHECK_CHACHA20_TRIES; t++){
+		for(i = 0; i < CHACHA20_KEY_SIZE; i++)
+			key[i] = (unsigned char)rand();
+		for(i = 0; i < CHACHA20_NONCE_SIZE; i++)
+			nonce[i] = (unsigned char)rand();
+		counter = (uint32_t)rand();
+		len = (size_t)rand() % (CHECK_CHACHA20_MAX_LENGTH + 1);
+		for(i = 0; i < (int)len; i++)
+			in[i] = (unsigned char)rand();
+
+		reference_xor(key,nonce,counter,in,ref,len);
+
+		chacha20_init(&ctx,key,nonce,counter);
+		chacha20_xor(&ctx,in,one,len);
+
+		// odd pieces up to a little more than a chacha20_block4 run, so the runs start at any place of a block
+		chacha20_init(&ctx,key,nonce,counter);
+		for(done = 0; done < len; done += piece){
+			piece = 2 * ((size_t)rand() % (2*CHACHA20_BLOCK_SIZE + CHACHA20_BLOCK_SIZE/2)) + 1;
+			if(piece > len - done)
+				piece = len - done;
+			chacha20_xor(&ctx,in + done,cut + done,piece);
+		}
+
+		if(memcmp(one,ref,len) != 0 || memcmp(cut,ref,len) != 0){
+			if(bad == 0)
+				fprintf(stderr,"mismatch on a %lu byte message\n",(unsigned long)len);
+			bad++;
+		}
+	}
+	printf("pieces: %d messages up to %d bytes, %ld mismatches\n",CHECK_CHACHA20_TRIES,CHECK_CHACHA20_MAX_LENGTH,bad);
+	return bad;
+}
+
+int main(void) {
+	long bad = check_rfc_vector() + check_pieces();
+
+	if(bad != 0){
+		printf("check_chacha20 FAILED\n");
+		return EXIT_FAILURE;
+	}
+	printf("check_chacha20 passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,155 @@
+/**
+ * @file
+ * @brief Checks the character block codec against the bitfield codec it replaced.
+ *
+ * compress_chars_to_int and decompress_int_to_char used to set the bits one by one through the intbit and charbit
+ * bitfields. The same steps are kept here as the reference, built on the bitfield functions that are still in the
+ * library. The reference table is every combination of a full first byte and sampled values of the other three
+ * bytes, 98304 entries, so each position is checked with the terminating 0 and with the high bit set. Then the bulk
+ * pack_char_blocks and unpack_char_blocks, which use the byte swap of the machine, are checked block by block on
+ * random strings of every length up to a few hundred bytes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "../lib/bit_opts.h"
+
+/**
+ * Longest random string of the bulk check.
+ */
+#define CHECK_CODEC_MAX_LENGTH 300
+/**
+ * Random strings of each length.
+ */
+#define CHECK_CODEC_TRIES 20
+
+/**
+ *
+ * @param str Input string
+ * @return Compressed integer value
+ *
+ * @brief The bitfield compression, it stops at the terminating character.
+ */
+unsigned int reference_compress(const char* str){
+	intbit* ib = int_to_bits(0);
+	charbit* cb;
+	int bit_cnt = 31;
+	unsigned int res;
+	int i,j;
+
+	for(i = 0; i < 4 && str[i] != '\0'; ++i){
+		cb = char_to_bits(str[i]);
+		for(j = CHARBITLENGTH - 1; j >= 0; --j)
+			setbit_of_intbit(ib,bit_cnt--,getbit_of_charbit(cb,j));
+		free(cb);
+	}
+	res = bits_to_int(ib);
+	free(ib);
+	return res;
+}
+/**
+ *
+ * @param x Compressed integer
+ * @param str Output, 4 characters
+ *
+ * @brief The bitfield decompression.
+ */
+void reference_decompress(unsigned int x,char* str){
+	intbit* ib = int_to_bits(x);
+	charbit* cb;
+	int bit_cnt = 31;
+	int i,j;
+
+	for(i = 0; i < 4; ++i){
+		cb = char_to_bits(0);
+		for(j = CHARBITLENGTH - 1; j >= 0; --j)
+			setbit_of_charbit(cb,j,getbit_of_intbit(ib,bit_cnt--));
+		str[i] = bits_to_char(cb);
+		free(cb);
+	}
+	free(ib);
+}
+/**
+ *
+ * @return Number of the mismatches
+ *
+ * @brief Compares the single block functions with the reference table.
+ */
+long check_reference_table(void){
+	unsigned char s[5];
+	char ref[4],blk[4];
+	char* out;
+	unsigned int v;
+	uint32_t w;
+	long bad = 0,n = 0;
+	int a,b,c,d;
+
+	for(a = 0; a < 256; a++)
+		for(b = 0; b < 256; b += 17)
+			for(c = 0; c < 256; c += 51)
+				for(d = 0; d < 256; d += 85){
+					s[0] = a; s[1] = b; s[2] = c; s[3] = d; s[4] = 0;
+					v = reference_compress((char*)s);
+					w = (uint32_t)compress_chars_to_int((char*)s);
+					reference_decompress(v,ref);
+					out = decompress_int_to_char(w);
+					unpack_char_blocks(&w,1,blk);
+					if(w != v || memcmp(out,ref,4) != 0 || memcmp(blk,ref,4) != 0){
+						if(bad == 0)
+							fprintf(stderr,"%02x%02x%02x%02x: %08x, the reference is %08x\n",a,b,c,d,w,v);
+						bad++;
+					}
+					free(out);
+					n++;
+				}
+	printf("reference table: %ld entries, %ld mismatches\n",n,bad);
+	return bad;
+}
+/**
+ *
+ * @return Number of the mismatches
+ *
+ * @brief Compares the bulk functions with the reference on random strings without a terminating character inside.
+ */
+long check_bulk(void){
+	char m[CHECK_CODEC_MAX_LENGTH+4],out[CHECK_CODEC_MAX_LENGTH+4],ref[4];
+	uint32_t blocks[CHECK_CODEC_MAX_LENGTH/4+1];
+	size_t count,i;
+	long bad = 0;
+	int len,t,k;
+
+	srand(1);
+	for(len = 0; len <= CHECK_CODEC_MAX_LENGTH; len++){
+		for(t = 0; t < CHECK_CODEC_TRIES; t++){
+			for(k = 0; k < len; k++)
+				m[k] = (char)(1 + rand() % 255);
+			memset(m+len,0,4);
+			count = pack_char_blocks(m,len,blocks);
+			if(count != (size_t)(len+3)/4)
+				bad++;
+			unpack_char_blocks(blocks,count,out);
+			for(i = 0; i < count; i++){
+				if(blocks[i] != reference_compress(m+4*i))
+					bad++;
+				reference_decompress(blocks[i],ref);
+				if(memcmp(out+4*i,ref,4) != 0)
+					bad++;
+			}
+		}
+	}
+	printf("bulk: strings up to %d bytes, %ld mismatches\n",CHECK_CODEC_MAX_LENGTH,bad);
+	return bad;
+}
+
+int main(void) {
+	long bad = check_reference_table() + check_bulk();
+
+	if(bad != 0){
+		printf("check_codec FAILED\n");
+		return EXIT_FAILURE;
+	}
+	printf("check_codec passed\n");
+	return EXIT_SUCCESS;
+}
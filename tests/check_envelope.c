@@ -0,0 +1,354 @@
+/**
+ * @file
+ * @brief Checks the parsing and the authentication of the message envelopes.
+ *
+ * The fields of a received envelope are used in place, so the parser has to reject any length or header value that
+ * does not fit the decrypted buffer, and the Merkle shape has to stay in the bounds the receiver accepts. The check
+ * builds valid envelopes with two fresh key pairs, then truncated, extended and changed copies of them, and random
+ * mutations of the header and the lengths, which must not be read out of the buffer.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include "../lib/envelope.h"
+
+/**
+ * Key size of the check keys, enough for a packed block of a digest.
+ */
+#define CHECK_ENVELOPE_KEY_BITS 512
+/**
+ * Leaf chunk of the Merkle envelopes of the check.
+ */
+#define CHECK_ENVELOPE_CHUNK MERKLE_MIN_CHUNK_SIZE
+/**
+ * Random mutations of a valid envelope.
+ */
+#define CHECK_ENVELOPE_MUTATIONS 20000
+
+/**
+ * Number of the failed checks.
+ */
+int failures = 0;
+
+/**
+ *
+ * @param ok Result of the check
+ * @param what Description of the check
+ */
+void expect(int ok,const char* what){
+	if(!ok){
+		printf("FAILED: %s\n",what);
+		failures++;
+	}
+}
+/**
+ *
+ * @param keys Generated keys
+ * @param key Output key
+ * @param private_key 1 for the private key, 0 for the public key
+ */
+void set_check_key(rsa_keys* keys,rsa_key* key,int private_key){
+	mpz_init_set(key->k,private_key ? keys->pr : keys->pu);
+	mpz_init_set(key->n,keys->n);
+	mpz_init(key->p);
+	mpz_init(key->q);
+	mpz_init(key->dp);
+	mpz_init(key->dq);
+	mpz_init(key->qinv);
+	if(private_key){
+		mpz_set(key->p,keys->p);
+		mpz_set(key->q,keys->q);
+		mpz_set(key->dp,keys->dp);
+		mpz_set(key->dq,keys->dq);
+		mpz_set(key->qinv,keys->qinv);
+	}
+	key->crt = private_key;
+	key->ctx = NULL;
+}
+/**
+ *
+ * @param key Key set with set_check_key
+ */
+void free_check_key(rsa_key* key){
+	free_rsa_key_ctx(key->ctx);
+	mpz_clear(key->k);
+	mpz_clear(key->n);
+	mpz_clear(key->p);
+	mpz_clear(key->q);
+	mpz_clear(key->dp);
+	mpz_clear(key->dq);
+	mpz_clear(key->qinv);
+}
+/**
+ *
+ * @param pu Output public key
+ * @param pr Output private key
+ */
+void create_check_keys(rsa_key* pu,rsa_key* pr){
+	rsa_key_base* key_base = generate_rsa_key_base(CHECK_ENVELOPE_KEY_BITS);
+	rsa_keys* keys = create_pub_key(key_base);
+
+	set_check_key(keys,pu,0);
+	set_check_key(keys,pr,1);
+	free_rsa_keys(keys);
+	free_rsa_key_base(key_base);
+}
+/**
+ *
+ * @param mode Signature mode
+ * @param m Plain text
+ * @param m_size Size of the plain text
+ * @param pr Sender's private key
+ * @param size Output, size of the envelope
+ * @return The envelope
+ *
+ * @brief Builds an envelope the way send_message does, without the encryption.
+ */
+char* build_envelope(int mode,const char* m,size_t m_size,rsa_key* pr,size_t* size){
+	unsigned char prefix[ENVELOPE_PREFIX_SIZE];
+	unsigned char sha256sum[32];
+	sha256_context ctx;
+	char *suffix,*env;
+	size_t suffix_size;
+
+	if(mode == ENVELOPE_SIG_MERKLE){
+		put_envelope_prefix(prefix,mode,CHECK_ENVELOPE_CHUNK,2,m_size);
+		create_merkle_root(m,m_size,CHECK_ENVELOPE_CHUNK,2,sha256sum);
+	}
+	else{
+		put_envelope_prefix(prefix,mode,0,0,m_size);
+		sha256_starts(&ctx);
+		sha256_update_buffer(&ctx,m,m_size);
+		sha256_finish(&ctx,sha256sum);
+	}
+	suffix = create_envelope_suffix(sha256sum,pr,&suffix_size);
+
+	*size = ENVELOPE_PREFIX_SIZE + m_size + suffix_size;
+	env = (char*)malloc(*size);
+	memcpy(env,prefix,ENVELOPE_PREFIX_SIZE);
+	memcpy(env+ENVELOPE_PREFIX_SIZE,m,m_size);
+	memcpy(env+ENVELOPE_PREFIX_SIZE+m_size,suffix,suffix_size);
+	free(suffix);
+	return env;
+}
+/**
+ *
+ * @param env Envelope
+ * @param size Size of the envelope
+ * @param pu Public key of the sender
+ * @return true(1) if the envelope is parsed and authenticated, false(0) otherwise
+ */
+int check_envelope(const char* env,size_t size,rsa_key* pu){
+	envelope e;
+
+	return parse_envelope(env,size,&e) && authenticate_envelope(&e,pu);
+}
+/**
+ *
+ * @param env A valid envelope, it is restored after each change
+ * @param size Size of the envelope
+ * @param offset Offset of the 8 byte number
+ * @param value Value written in place of the number
+ * @param what Description of the check
+ *
+ * @brief Checks that the envelope is rejected when the number is changed.
+ */
+void expect_rejected_number(char* env,size_t size,size_t offset,unsigned long long value,const char* what){
+	unsigned char saved[8];
+	envelope e;
+
+	memcpy(saved,env+offset,8);
+	put_uint_be((unsigned char*)env+offset,value,8);
+	expect(!parse_envelope(env,size,&e),what);
+	memcpy(env+offset,saved,8);
+}
+/**
+ *
+ * @param pu Sender's public key
+ * @param pr Sender's private key
+ * @param other_pu Public key of another user
+ *
+ * @brief Valid envelopes are authenticated with the sender's key only, and any change of the signed data fails.
+ */
+void check_valid(rsa_key* pu,rsa_key* pr,rsa_key* other_pu){
+	size_t m_size = 3*CHECK_ENVELOPE_CHUNK + 5,size;
+	char* m = (char*)malloc(m_size);
+	char* env;
+	envelope e;
+	size_t i;
+
+	for(i = 0; i < m_size; i++)
+		m[i] = (char)(i*131 + 7);
+
+	env = build_envelope(ENVELOPE_SIG_HASH,m,m_size,pr,&size);
+	expect(check_envelope(env,size,pu),"hash envelope is authenticated");
+	expect(parse_envelope(env,size,&e) && e.message.data == env+ENVELOPE_PREFIX_SIZE && e.message.size == m_size,
+			"message view points into the envelope");
+	expect(!check_envelope(env,size,other_pu),"hash envelope fails with another sender's key");
+	env[ENVELOPE_PREFIX_SIZE+m_size/2] ^= 1;
+	expect(!check_envelope(env,size,pu),"changed message fails");
+	env[ENVELOPE_PREFIX_SIZE+m_size/2] ^= 1;
+	env[ENVELOPE_PREFIX_SIZE+m_size+ENVELOPE_LENGTH_SIZE] ^= 1;
+	expect(!check_envelope(env,size,pu),"changed signature fails");
+	free(env);
+
+	env = build_envelope(ENVELOPE_SIG_HASH,"",0,pr,&size);
+	expect(check_envelope(env,size,pu),"empty message is authenticated");
+	free(env);
+
+	env = build_envelope(ENVELOPE_SIG_MERKLE,m,m_size,pr,&size);
+	expect(check_envelope(env,size,pu),"Merkle envelope is authenticated");
+	env[ENVELOPE_PREFIX_SIZE+CHECK_ENVELOPE_CHUNK] ^= 1;
+	expect(!check_envelope(env,size,pu),"changed chunk of a Merkle envelope fails");
+	free(env);
+	free(m);
+}
+/**
+ *
+ * @param pr Sender's private key
+ *
+ * @brief Truncated, extended and changed envelopes are rejected by the parser.
+ */
+void check_malformed(rsa_key* pr){
+	const char* m = "the plain text of the malformed envelopes";
+	size_t m_size = strlen(m),size,i,sig_pos;
+	char *env,*longer;
+	envelope e;
+	int rejected = 1;
+
+	env = build_envelope(ENVELOPE_SIG_MERKLE,m,m_size,pr,&size);
+	expect(parse_envelope(env,size,&e),"Merkle envelope is parsed");
+
+	for(i = 0; i < size; i++)
+		rejected = rejected && !parse_envelope(env,i,&e);
+	expect(rejected,"every truncated envelope is rejected");
+
+	longer = (char*)malloc(size+1);
+	memcpy(longer,env,size);
+	longer[size] = 0;
+	expect(!parse_envelope(longer,size+1,&e),"trailing byte is rejected");
+	free(longer);
+
+	env[0] ^= 1;
+	expect(!parse_envelope(env,size,&e),"wrong magic is rejected");
+	env[0] ^= 1;
+	env[4] = ENVELOPE_VERSION + 1;
+	expect(!parse_envelope(env,size,&e),"newer version is rejected");
+	env[4] = ENVELOPE_VERSION;
+	env[5] = 0;
+	expect(!parse_envelope(env,size,&e),"signature mode 0 is rejected");
+	env[5] = 3;
+	expect(!parse_envelope(env,size,&e),"unknown signature mode is rejected");
+	env[5] = ENVELOPE_SIG_MERKLE;
+
+	expect_rejected_number(env,size,8,0,"chunk 0 is rejected");
+	expect_rejected_number(env,size,8,1,"chunk 1 is rejected");
+	expect_rejected_number(env,size,8,MERKLE_MIN_CHUNK_SIZE-1,"chunk below the minimum is rejected");
+	expect_rejected_number(env,size,8,(unsigned long long)MERKLE_MAX_CHUNK_SIZE+1,"chunk above the maximum is rejected");
+	expect_rejected_number(env,size,8,SIZE_MAX,"chunk SIZE_MAX is rejected");
+	expect_rejected_number(env,size,16,0,"arity 0 is rejected");
+	expect_rejected_number(env,size,16,1,"arity 1 is rejected");
+	expect_rejected_number(env,size,16,MERKLE_MAX_ARITY+1,"arity above the maximum is rejected");
+	expect_rejected_number(env,size,16,SIZE_MAX,"arity SIZE_MAX is rejected");
+
+	expect_rejected_number(env,size,ENVELOPE_HEADER_SIZE,m_size+1,"message length past the end is rejected");
+	expect_rejected_number(env,size,ENVELOPE_HEADER_SIZE,size,"message length of the whole envelope is rejected");
+	expect_rejected_number(env,size,ENVELOPE_HEADER_SIZE,ULLONG_MAX,"message length 2^64-1 is rejected");
+	expect_rejected_number(env,size,ENVELOPE_HEADER_SIZE,ULLONG_MAX-ENVELOPE_PREFIX_SIZE+1,"wrapping message length is rejected");
+	expect_rejected_number(env,size,ENVELOPE_HEADER_SIZE,m_size-1,"short message length is rejected");
+	sig_pos = ENVELOPE_PREFIX_SIZE + m_size;
+	expect_rejected_number(env,size,sig_pos,ULLONG_MAX,"signature length 2^64-1 is rejected");
+	expect_rejected_number(env,size,sig_pos,size,"signature length past the end is rejected");
+	expect_rejected_number(env,size,size-KEY_FINGERPRINT_SIZE-ENVELOPE_LENGTH_SIZE,KEY_FINGERPRINT_SIZE+1,
+			"fingerprint length past the end is rejected");
+
+	expect(parse_envelope(env,size,&e),"restored envelope is parsed");
+	free(env);
+}
+/**
+ *
+ * @param pu Sender's public key
+ * @param pr Sender's private key
+ *
+ * @brief Random changes of the header and the lengths, the views of a parsed envelope stay in the buffer.
+ */
+void check_mutations(rsa_key* pu,rsa_key* pr){
+	const char* m = "mutated";
+	size_t m_size = strlen(m),size,pos,i;
+	char *env,*copy;
+	envelope e;
+	int in_bounds = 1,n,k;
+
+	env = build_envelope(ENVELOPE_SIG_MERKLE,m,m_size,pr,&size);
+	copy = (char*)malloc(size);
+	srand(1);
+	for(i = 0; i < CHECK_ENVELOPE_MUTATIONS; i++){
+		memcpy(copy,env,size);
+		n = 1 + rand() % 4;
+		for(k = 0; k < n; k++){// mostly the header and the length of the plain text, sometimes any byte
+			pos = rand() % 4 != 0 ? (size_t)(rand() % ENVELOPE_PREFIX_SIZE) : (size_t)rand() % size;
+			copy[pos] = (char)rand();
+		}
+		if(parse_envelope(copy,size,&e)){
+			in_bounds = in_bounds && e.message.data >= copy && e.message.data + e.message.size <= copy + size
+					&& e.signature.data + e.signature.size <= copy + size
+					&& e.fingerprint.data + e.fingerprint.size == copy + size;
+			authenticate_envelope(&e,pu);
+		}
+	}
+	expect(in_bounds,"views of the mutated envelopes stay in the buffer");
+	free(copy);
+	free(env);
+}
+/**
+ *
+ * @param s_pu Sender's public key
+ * @param s_pr Sender's private key
+ * @param r_pu Receiver's public key
+ * @param r_pr Receiver's private key
+ *
+ * @brief An envelope encrypted in a single pass with pub_enc_bin_framed is parsed after pri_dec_container.
+ */
+void check_round_trip(rsa_key* s_pu,rsa_key* s_pr,rsa_key* r_pu,rsa_key* r_pr){
+	unsigned char prefix[ENVELOPE_PREFIX_SIZE];
+	char m[] = "a message that is signed and encrypted in a single pass";
+	size_t m_size = strlen(m),c_size,d_size;
+	char *c,*d;
+	envelope e;
+
+	put_envelope_prefix(prefix,ENVELOPE_SIG_HASH,0,0,m_size);
+	c = pub_enc_bin_framed((char*)prefix,ENVELOPE_PREFIX_SIZE,m,m_size,NULL,0,create_envelope_suffix,s_pr,r_pu,&c_size);
+	d = pri_dec_container(c,c_size,r_pr,&d_size);
+	expect(parse_envelope(d,d_size,&e) && e.message.size == m_size && memcmp(e.message.data,m,m_size) == 0,
+			"decrypted envelope is parsed");
+	expect(authenticate_envelope(&e,s_pu),"decrypted envelope is authenticated");
+	free(c);
+	free(d);
+}
+
+int main(void) {
+	rsa_key s_pu,s_pr,r_pu,r_pr;
+
+	create_check_keys(&s_pu,&s_pr);
+	create_check_keys(&r_pu,&r_pr);
+
+	check_valid(&s_pu,&s_pr,&r_pu);
+	check_malformed(&s_pr);
+	check_mutations(&s_pu,&s_pr);
+	check_round_trip(&s_pu,&s_pr,&r_pu,&r_pr);
+
+	free_check_key(&s_pu);
+	free_check_key(&s_pr);
+	free_check_key(&r_pu);
+	free_check_key(&r_pr);
+
+	if(failures != 0){
+		printf("check_envelope FAILED, %d failures\n",failures);
+		return EXIT_FAILURE;
+	}
+	printf("check_envelope passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+/**
+ * @file
+ * @brief Checks the modular exponentiation functions against mpz_powm.
+ *
+ * exp_with_windows_mont, exp_short_mont and take_mod_of_exp_number2 work on the limbs of the numbers with their own
+ * window recoding and Montgomery reduction, so a wrong carry or a wrong window only shows up for some of the inputs.
+ * The check draws odd moduli of 62 to 2560 bits, with bases and exponents of random sizes, and takes exponent 0,
+ * base 0, base 1, base n-1 and bases larger than the modulo number as special cases. Every result is compared with
+ * mpz_powm.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "../lib/math_opts.h"
+
+/**
+ * Number of the random cases.
+ */
+#define CHECK_EXP_CASES 3000
+/**
+ * Bit length of the smallest modulo number.
+ */
+#define CHECK_EXP_MIN_BITS 62
+/**
+ * Bit length of the largest modulo number.
+ */
+#define CHECK_EXP_MAX_BITS 2560
+
+/**
+ * Number of the failed comparisons.
+ */
+long failures = 0;
+
+/**
+ *
+ * @param what Name of the function
+ * @param f Its result
+ * @param ref Result of mpz_powm
+ * @param base Base number
+ * @param power Power of the number
+ * @param mod Modulo number
+ *
+ * @brief Compares a result with mpz_powm, the first wrong case is printed.
+ */
+void expect_powm(const char* what,mpz_t f,mpz_t ref,mpz_t base,mpz_t power,mpz_t mod){
+	if(mpz_cmp(f,ref) == 0)
+		return;
+	if(failures == 0)
+		gmp_fprintf(stderr,"%s: %Zx^%Zx mod %Zx is %Zx, mpz_powm gives %Zx\n",what,base,power,mod,f,ref);
+	failures++;
+}
+/**
+ *
+ * @param base Output, base of the case
+ * @param mod Modulo number
+ * @param kind Index of the case, some of them take a special base
+ * @param state GMP random state
+ *
+ * @brief Picks the base of a case, 0, 1, n-1, a base above the modulo number or a random one.
+ */
+void pick_base(mpz_t base,mpz_t mod,int kind,gmp_randstate_t state){
+	switch(kind % 8){
+	case 0:
+		mpz_set_ui(base,0);
+		break;
+	case 1:
+		mpz_set_ui(base,1);
+		break;
+	case 2:
+		mpz_sub_ui(base,mod,1);
+		break;
+	case 3:// larger than the modulo number, it is reduced first
+		mpz_urandomb(base,state,mpz_sizeinbase(mod,2) + 1 + gmp_urandomm_ui(state,64));
+		mpz_add(base,base,mod);
+		break;
+	default:
+		mpz_urandomm(base,state,mod);
+		break;
+	}
+}
+/**
+ *
+ * @param power Output, exponent of the case
+ * @param mod Modulo number
+ * @param kind Index of the case, some of them take a special exponent
+ * @param state GMP random state
+ *
+ * @brief Picks the exponent of a case, 0, 1, a short one or one of up to the size of the modulo number.
+ */
+void pick_power(mpz_t power,mpz_t mod,int kind,gmp_randstate_t state){
+	switch(kind % 5){
+	case 0:
+		mpz_set_ui(power,0);
+		break;
+	case 1:
+		mpz_set_ui(power,1);
+		break;
+	case 2:
+		mpz_urandomb(power,state,1 + gmp_urandomm_ui(state,64));
+		break;
+	default:
+		mpz_urandomb(power,state,1 + gmp_urandomm_ui(state,mpz_sizeinbase(mod,2)));
+		break;
+	}
+}
+/**
+ *
+ * @param state GMP random state
+ * @param i Index of the case
+ *
+ * @brief Draws an odd modulo number and compares the three functions with mpz_powm on it.
+ */
+void check_case(gmp_randstate_t state,int i){
+	mpz_t mod,base,power,ref,f;
+	unsigned long short_power;
+	exp_windows* w;
+	mont_ctx* ctx;
+	size_t bits = CHECK_EXP_MIN_BITS + gmp_urandomm_ui(state,CHECK_EXP_MAX_BITS - CHECK_EXP_MIN_BITS + 1);
+
+	mpz_inits(mod,base,power,ref,f,NULL);
+	mpz_urandomb(mod,state,bits);
+	mpz_setbit(mod,bits - 1);
+	mpz_setbit(mod,0);
+	pick_base(base,mod,i,state);
+	pick_power(power,mod,i / 8,state);
+
+	ctx = create_mont_ctx(mod);
+	w = recode_exponent(power);
+	mpz_powm(ref,base,power,mod);
+	exp_with_windows_mont(f,base,w,ctx);
+	expect_powm("exp_with_windows_mont",f,ref,base,power,mod);
+	take_mod_of_exp_number2(f,base,power,mod);
+	expect_powm("take_mod_of_exp_number2",f,ref,base,power,mod);
+
+	// the short exponent path takes the low limb of the exponent, 65537 and 3 are the usual public exponents
+	short_power = i % 3 == 0 ? 65537 : i % 3 == 1 ? 3 : mpz_getlimbn(power,0);
+	mpz_set_ui(power,short_power);
+	mpz_powm(ref,base,power,mod);
+	exp_short_mont(f,base,short_power,ctx);
+	expect_powm("exp_short_mont",f,ref,base,power,mod);
+
+	free_exp_windows(w);
+	free_mont_ctx(ctx);
+	mpz_clears(mod,base,power,ref,f,NULL);
+}
+
+int main(void) {
+	gmp_randstate_t state;
+	int i;
+
+	gmp_randinit_default(state);
+	gmp_randseed_ui(state,1);
+	for(i = 0; i < CHECK_EXP_CASES; i++)
+		check_case(state,i);
+	gmp_randclear(state);
+	printf("%d cases with odd modulo numbers of %d to %d bits, %ld mismatches\n",CHECK_EXP_CASES,CHECK_EXP_MIN_BITS,
+			CHECK_EXP_MAX_BITS,failures);
+
+	if(failures != 0){
+		printf("check_exp FAILED\n");
+		return EXIT_FAILURE;
+	}
+	printf("check_exp passed\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,216 @@
+/**
+ * @file
+ * @brief Checks the SHA-256 compression variants against the generic one.
+ *
+ * sha256_update picks the SHA extensions, the SSSE3 message schedule or the ARMv8 SHA2 instructions at startup, so
+ * only one of them runs on a given machine and the others are never hashed with. The check runs every variant the
+ * CPU supports next to sha256_blocks_generic on random multi-block inputs from random states, and hashes the FIPS
+ * 180-2 "abc" and two-block messages with each variant and through sha256_update.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../lib/sha256.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#elif defined(__aarch64__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+/**
+ * Most blocks of a random input.
+ */
+#define CHECK_SHA256_MAX_BLOCKS 64
+/**
+ * Random inputs of each block count.
+ */
+#define CHECK_SHA256_TRIES 50
+/**
+ * Most compression variants of a machine, the generic one included.
+ */
+#define CHECK_SHA256_MAX_VARIANTS 4
+
+/**
+ * A compression variant and its name.
+ */
+typedef struct SHA256_VARIANT {
+	const char* name; // name of the function
+	sha256_blocks_fn blocks; // the compression
+}sha256_variant;
+
+/**
+ * FIPS 180-2 digest of "abc".
+ */
+const unsigned char abc_digest[32] = {
+	0xba,0x78,0x16,0xbf,0x8f,0x01,0xcf,0xea,0x41,0x41,0x40,0xde,0x5d,0xae,0x22,0x23,
+	0xb0,0x03,0x61,0xa3,0x96,0x17,0x7a,0x9c,0xb4,0x10,0xff,0x61,0xf2,0x00,0x15,0xad
+};
+/**
+ * FIPS 180-2 two-block message and its digest.
+ */
+const char* two_block_msg = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+const unsigned char two_block_digest[32] = {
+	0x24,0x8d,0x6a,0x61,0xd2,0x06,0x38,0xb8,0xe5,0xc0,0x26,0x93,0x0c,0x3e,0x60,0x39,
+	0xa3,0x3c,0xe4,0x59,0x64,0xff,0x21,0x67,0xf6,0xec,0xed,0xd4,0x19,0xdb,0x06,0xc1
+};
+
+/**
+ *
+ * @param variants Output, the variants the CPU supports, the generic one first
+ * @return Number of the variants
+ *
+ * @brief Finds the variants with the same CPU tests the dispatch uses.
+ */
+int supported_variants(sha256_variant* variants){
+	int count = 0;
+
+	variants[count].name = "sha256_blocks_generic";
+	variants[count++].blocks = sha256_blocks_generic;
+#if defined(__x86_64__) || defined(__i386__)
+	unsigned int a,b,c,d;
+
+	if(__get_cpuid(1,&a,&b,&c,&d) && ((c >> 9) & 1)){
+		variants[count].name = "sha256_blocks_ssse3";
+		variants[count++].blocks = sha256_blocks_ssse3;
+		if(((c >> 19) & 1) && __get_cpuid_count(7,0,&a,&b,&c,&d) && ((b >> 29) & 1)){
+			variants[count].name = "sha256_blocks_shani";
+			variants[count++].blocks = sha256_blocks_shani;
+		}
+	}
+#elif defined(__aarch64__)
+	if(getauxval(AT_HWCAP) & HWCAP_SHA2){
+		variants[count].name = "sha256_blocks_armv8";
+		variants[count++].blocks = sha256_blocks_armv8;
+	}
+#endif
+	return count;
+}
+/**
+ *
+ * @param blocks The compression
+ * @param msg The message
+ * @param len Length of the message, below 120 bytes
+ * @param digest Output, 32 byte digest
+ *
+ * @brief Pads the message to whole blocks and hashes it with the compression alone.
+ */
+void digest_with(sha256_blocks_fn blocks,const char* msg,size_t len,unsigned char* digest){
+	unsigned char buf[128];
+	size_t padded = len + 9 <= 64 ? 64 : 128;
+	unsigned long long bits = (unsigned long long)len * 8;
+	sha256_context ctx;
+	int i;
+
+	memset(buf,0,sizeof(buf));
+	memcpy(buf,msg,len);
+	buf[len] = 0x80;
+	for(i = 0; i < 8; i++)
+		buf[padded - 1 - i] = (unsigned char)(bits >> (8 * i));
+
+	sha256_starts(&ctx);
+	blocks(&ctx,buf,padded / 64);
+	for(i = 0; i < 32; i++)
+		digest[i] = (unsigned char)(ctx.state[i / 4] >> (24 - 8 * (i % 4)));
+}
+/**
+ *
+ * @param variants The variants
+ * @param count Number of the variants
+ * @return Number of the wrong digests
+ *
+ * @brief Hashes the FIPS 180-2 messages with each variant and through sha256_update.
+ */
+int check_known_answers(const sha256_variant* variants,int count){
+	unsigned char digest[32];
+	sha256_context ctx;
+	int bad = 0,i;
+
+	for(i = 0; i < count; i++){
+		digest_with(variants[i].blocks,"abc",3,digest);
+		if(memcmp(digest,abc_digest,32) != 0){
+			fprintf(stderr,"%s: wrong digest of \"abc\"\n",variants[i].name);
+			bad++;
+		}
+		digest_with(variants[i].blocks,two_block_msg,strlen(two_block_msg),digest);
+		if(memcmp(digest,two_block_digest,32) != 0){
+			fprintf(stderr,"%s: wrong digest of the two-block message\n",variants[i].name);
+			bad++;
+		}
+	}
+
+	sha256_starts(&ctx);
+	sha256_update(&ctx,(uint8*)"abc",3);
+	sha256_finish(&ctx,digest);
+	if(memcmp(digest,abc_digest,32) != 0){
+		fprintf(stderr,"sha256_update: wrong digest of \"abc\"\n");
+		bad++;
+	}
+	sha256_starts(&ctx);
+	sha256_update(&ctx,(uint8*)two_block_msg,strlen(two_block_msg));
+	sha256_finish(&ctx,digest);
+	if(memcmp(digest,two_block_digest,32) != 0){
+		fprintf(stderr,"sha256_update: wrong digest of the two-block message\n");
+		bad++;
+	}
+	printf("known answers: %d variants, %d wrong digests\n",count,bad);
+	return bad;
+}
+/**
+ *
+ * @param variants The variants
+ * @param count Number of the variants
+ * @return Number of the mismatches
+ *
+ * @brief Compares the state after each variant with the state after the generic compression on random blocks.
+ */
+long check_random_blocks(const sha256_variant* variants,int count){
+	unsigned char data[CHECK_SHA256_MAX_BLOCKS*64];
+	sha256_context ref,ctx;
+	long bad = 0;
+	int blocks,t,i,j;
+
+	srand(1);
+	for(blocks = 1; blocks <= CHECK_SHA256_MAX_BLOCKS; blocks++){
+		for(t = 0; t < CHECK_SHA256_TRIES; t++){
+			for(j = 0; j < blocks*64; j++)
+				data[j] = (unsigned char)rand();
+			sha256_starts(&ref);
+			if(t % 2 == 1)// every other input starts from a random state
+				for(j = 0; j < 8; j++)
+					ref.state[j] = ((uint32)rand() << 16) ^ (uint32)rand();
+			ctx = ref;
+			sha256_blocks_generic(&ref,data,blocks);
+			for(i = 1; i < count; i++){
+				sha256_context v = ctx;
+
+				variants[i].blocks(&v,data,blocks);
+				if(memcmp(v.state,ref.state,sizeof(ref.state)) != 0){
+					if(bad == 0)
+						fprintf(stderr,"%s: wrong state after %d blocks\n",variants[i].name,blocks);
+					bad++;
+				}
+			}
+		}
+	}
+	printf("random blocks: up to %d blocks, %ld mismatches\n",CHECK_SHA256_MAX_BLOCKS,bad);
+	return bad;
+}
+
+int main(void) {
+	sha256_variant variants[CHECK_SHA256_MAX_VARIANTS];
+	int count = supported_variants(variants),i;
+	long bad;
+
+	for(i = 0; i < count; i++)
+		printf("%s\n",variants[i].name);
+	bad = check_known_answers(variants,count) + check_random_blocks(variants,count);
+
+	if(bad != 0){
+		printf("check_sha256 FAILED\n");
+		return EXIT_FAILURE;
+	}
+	printf("check_sha256 passed\n");
+	return EXIT_SUCCESS;
+}